@@ -0,0 +1,231 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Functions for decoding DCCP Ack Vectors.
+
+Copyright (C) 2013  Samuel Jero <sj323707@ohio.edu>
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: Samuel Jero <sj323707@ohio.edu>
+Date: 02/2013
+Contributors: dccp2tcp contributors, 10/2026 (decoder rewritten, interp_ack_vect()
+	moved out of connections.c)
+
+Notes:
+	1)An Ack Vector byte is a 2 bit state and a 6 bit run length (+1 packets),
+		working BACKWARDS through sequence space from the Acknowledgement
+		Number. decode_ack_vect() merges consecutive bytes with the same
+		state into a single run, so a long stretch of received packets is one
+		run no matter how many bytes it took.
+	2)Bytes are decoded with a lookup table. Stretches of received packets
+		are skipped 8 bytes at a time: if no state bit is set in a 64 bit
+		word, the run lengths are summed without looking at each byte.
+	3)The table is constant and built by the compiler, so contexts on
+		several threads can share it without any setup.
+	4)A packet's Ack Vector is decoded once, into d2t->av, by the first
+		of the conversion, SACK, statistics and columns code to need it
+		(read_ack_vect()). Its warnings are counted once, for the sender.
+	5)A packet received ECN marked (state 1) was received. Only the TCP
+		view treats it like a loss, as it always has: it sets the
+		adjustment of the ACK and isn't covered by SACK blocks. The losses,
+		the statistics (which count it as delivered, and as ecn) and the
+		columns file count it as received.
+******************************************************************************/
+#include "dccp2tcp.h"
+
+#define AV_STATE_BITS	0xC0C0C0C0C0C0C0C0ULL	/*State bits of 8 vector bytes*/
+
+/*Decoded Ack Vector byte*/
+struct av_byte{
+	u_char		state;	/*Packet state*/
+	u_char		len;	/*Packets in run*/
+};
+
+/*Decoding table, shared by all contexts: entry i is state i>>6, length (i&0x3F)+1*/
+#define AV_BYTE(i)		{(i) >> 6, ((i) & 0x3F) + 1}
+#define AV_BYTE4(i)		AV_BYTE(i), AV_BYTE((i) + 1), AV_BYTE((i) + 2), AV_BYTE((i) + 3)
+#define AV_BYTE16(i)	AV_BYTE4(i), AV_BYTE4((i) + 4), AV_BYTE4((i) + 8), AV_BYTE4((i) + 12)
+#define AV_BYTE64(i)	AV_BYTE16(i), AV_BYTE16((i) + 16), AV_BYTE16((i) + 32), AV_BYTE16((i) + 48)
+static const struct av_byte	av_tbl[256]={AV_BYTE64(0), AV_BYTE64(64), AV_BYTE64(128), AV_BYTE64(192)};
+
+int av_received(const u_char *cur, const u_char *end, int *len);
+void av_summary(struct hcon *hcn, struct ack_vect *av);
+
+
+/*Ack Vector of the packet being converted, sent by hcn. It is decoded on
+ * the first call for each packet*/
+struct ack_vect* read_ack_vect(const u_char* hdr, struct hcon *hcn)
+{
+	if(!d2t->av.valid){
+		decode_ack_vect(hdr, hcn, &d2t->av);
+	}
+return &d2t->av;
+}
+
+/*Decode the Ack Vector options of a DCCP packet (which must have an
+ * Acknowledgement Number), sent by hcn (may be NULL), into av: runs newest
+ * first (av->n is -1 if there is no Ack Vector), losses and
+ * interp_ack_vect()'s adjustment*/
+void decode_ack_vect(const u_char* hdr, struct hcon *hcn, struct ack_vect *av)
+{
+	struct av_run					*runs=av->runs;
+	const struct dccp_hdr_ack_bits	*dccphack;
+	int								hdrlen;
+	int								optlen;
+	int								len;
+	int								n=-1;
+	int								skip;
+	d_seq_num						bp;
+	const u_char					*opt;
+	const u_char					*cur;
+	const u_char					*end;
+	u_char							state;
+
+	/*setup pointer to DCCP options and determine how long the options are*/
+	hdrlen=((struct dccp_hdr*)hdr)->dccph_doff*4;
+	dccphack=(struct dccp_hdr_ack_bits*)(hdr + sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext));
+	optlen=hdrlen-sizeof(struct dccp_hdr) - sizeof(struct dccp_hdr_ext) - sizeof(struct dccp_hdr_ack_bits);
+	opt=hdr + sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext) + sizeof(struct dccp_hdr_ack_bits);
+	bp=ntohl(dccphack->dccph_ack_nr_low);
+
+	/*parse options*/
+	while(optlen > 0){
+
+		/*One byte options (no length)*/
+		if(*opt< 32){
+			optlen--;
+			opt++;
+			continue;
+		}
+
+		/*Check option length*/
+		len=*(opt+1);
+		if(len > optlen || len < 2){
+			warnprintf(hcn, WARN_OPT_OVERRUN, "Warning: Option would extend into packet data\n");
+			break;
+		}
+
+		/*Ack Vector Option*/
+		if(*opt==38 || *opt==39){
+			if(n < 0){
+				n=0;
+			}
+			cur=opt+2;
+			end=opt+len;
+			while(cur < end){
+				/*Long stretches of received packets are counted in one go*/
+				state=av_tbl[*cur].state;
+				skip=0;
+				if(state==AV_RECEIVED){
+					cur+=av_received(cur, end, &skip);
+				}else{
+					skip=av_tbl[*cur].len;
+					cur++;
+				}
+
+				/*extend the current run or start a new one*/
+				if(n > 0 && runs[n-1].state==state){
+					runs[n-1].len+=skip;
+				}else if(n < AV_MAX_RUNS){
+					runs[n].state=state;
+					runs[n].top=bp;
+					runs[n].len=skip;
+					n++;
+				}else{
+					warnprintf(hcn, WARN_ACK_VECT, "Warning: Too many Ack Vector runs\n");
+					optlen=0;
+					break;
+				}
+				bp-=skip;
+			}
+		}
+
+		optlen-=len;
+		opt+=len;
+	}
+	av->n=n;
+	av_summary(hcn, av);
+	av->valid=1;
+}
+
+/*Count the received packets from cur up to the first byte with a different
+ * state (or end). Returns the number of bytes consumed*/
+int av_received(const u_char *cur, const u_char *end, int *len)
+{
+	const u_char	*start=cur;
+	u_int64_t		w;
+
+	/*8 bytes at a time while no state bits are set*/
+	while(end - cur >= 8){
+		memcpy(&w, cur, 8);
+		if(w & AV_STATE_BITS){
+			break;
+		}
+		/*sum the 8 run lengths: pairwise into 16 bit lanes, then across*/
+		w=(w & 0x00FF00FF00FF00FFULL) + ((w >> 8) & 0x00FF00FF00FF00FFULL);
+		*len+=((w * 0x0001000100010001ULL) >> 48) + 8;
+		cur+=8;
+	}
+
+	/*the rest one at a time*/
+	while(cur < end && av_tbl[*cur].state==AV_RECEIVED){
+		*len+=av_tbl[*cur].len;
+		cur++;
+	}
+return cur - start;
+}
+
+/*Compute the adjustment and losses of a decoded Ack Vector*/
+void av_summary(struct hcon *hcn, struct ack_vect *av)
+{
+	int		bp=0;
+	int		invalid=0;
+
+	/*keep track of total packets recieved and if
+	a packet is lost, subtract all packets received
+	after that*/
+	av->additional=0;
+	av->lost=0;
+	for(int i=0; i < av->n; i++){
+		bp+=av->runs[i].len;
+		if(av->runs[i].state==AV_LOST || av->runs[i].state==AV_ECN){
+			av->additional= -bp;
+		}
+		if(av->runs[i].state==AV_LOST){
+			av->lost+=av->runs[i].len;
+		}
+		if(av->runs[i].state==AV_INVALID){
+			invalid=1;
+		}
+	}
+	if(invalid){
+		warnprintf(hcn, WARN_ACK_VECT, "Warning: Invalid Ack Vector!! (Linux will handle poorly!)\n");
+	}
+	dbgprintf(2,"Ack vector adding: %i\n", av->additional);
+}
+
+/*Parse Ack Vector Options of a packet sent by hcn
+ * Returns the Number of packets since last recorded loss*/
+unsigned int interp_ack_vect(u_char* hdr, struct hcon *hcn)
+{
+	return read_ack_vect(hdr, hcn)->additional;
+}
+
+/*Count the packets reported lost (not received) in Ack Vector Options of
+ * a packet sent by hcn*/
+unsigned int ack_vect_losses(u_char* hdr, struct hcon *hcn)
+{
+	return read_ack_vect(hdr, hcn)->lost;
+}
@@ -0,0 +1,481 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Converting many captures on a pool of worker threads.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	1)Each file is converted in its own context (struct d2t_ctx) with the
+		options of the command line, so files share no state and workers
+		take the next file as soon as they are done with one.
+	2)Outputs are named after the input without its extension (stem):
+		outdir/stem.tcp.pcap for the TCP capture, outdir/stem.stats.csv (or
+		.json) for statistics, outdir/stem.prefix for --xplot=prefix graphs
+		and outdir/stem.file for --columns=file. The fixed suffix keeps an
+		output from taking the name of an input in the same directory.
+	3)Two inputs with the same stem would write the same outputs, and an
+		output that is one of the inputs would be truncated while it is
+		read, so both are refused before anything is converted.
+	4)The summary is printed at the end, in input order.
+******************************************************************************/
+#include "dccp2tcp.h"
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/*Result of one file*/
+struct batch_file{
+	char				*in;		/*Input file*/
+	char				*stem;		/*Output name (input base name without extension)*/
+	dev_t				dev;		/*Device of the input*/
+	ino_t				ino;		/*Inode of the input*/
+	int					failed;		/*Couldn't be converted*/
+	u_int64_t			packets;	/*Packets read*/
+	u_int64_t			converted;	/*TCP packets written*/
+	u_int64_t			warnings;	/*Warnings of all classes*/
+	int					conns;		/*Connections*/
+	double				secs;		/*Conversion time*/
+};
+
+/*Work shared by the workers*/
+struct batch{
+	const struct d2t_ctx	*opts;	/*Options for every file*/
+	const char			*outdir;	/*Output directory*/
+	struct batch_file	*files;		/*Files to convert*/
+	int					nfiles;		/*Number of files*/
+	int					next;		/*Next file to take*/
+	int					clash;		/*Two inputs have the same outputs*/
+	pthread_mutex_t		lock;		/*Protects next*/
+};
+
+/*Per file counters, kept by the pcap_loop callback*/
+struct batch_count{
+	struct d2t_ctx		*ctx;		/*Context of the file*/
+	u_int64_t			packets;	/*Packets read*/
+	u_int64_t			converted;	/*Packets converted*/
+};
+
+void *batch_worker(void *arg);
+void batch_file(struct batch *b, struct batch_file *f);
+void batch_packet(u_char *user, const struct pcap_pkthdr *h, const u_char *bytes);
+int batch_add(struct batch *b, char *in);
+int batch_check(struct batch *b);
+int batch_clash(struct batch *b, struct batch_file *f, const char *path);
+char *batch_path(const char *outdir, const char *name, const char *suffix);
+char *batch_stats_name(const struct d2t_ctx *opts);
+char *batch_goodput_name(const char *path);
+double batch_now();
+int batch_cmp(const void *a, const void *b);
+
+
+/*Convert the inputs (files, or directories of files) into outdir on jobs
+ * threads, with the options in opts. Returns the number of files that
+ * couldn't be converted*/
+int batch_convert(const struct d2t_ctx *opts, int jobs, const char *outdir, char **inputs, int ninputs)
+{
+	struct batch		b;
+	pthread_t			*threads;
+	u_int64_t			packets=0;
+	int					failed=0;
+	double				start;
+	double				secs;
+
+	memset(&b, 0, sizeof(struct batch));
+	b.opts=opts;
+	b.outdir=outdir;
+	for(int i=0; i < ninputs; i++){
+		if(batch_add(&b, inputs[i])){
+			failed++;
+		}
+	}
+	if(b.nfiles==0){
+		dbgprintf(0,"Error: No input files\n");
+		return failed + 1;
+	}
+	if(b.clash || batch_check(&b)){
+		for(int i=0; i < b.nfiles; i++){
+			free(b.files[i].in);
+			free(b.files[i].stem);
+		}
+		free(b.files);
+		return failed + 1;
+	}
+	if(jobs > b.nfiles){
+		jobs=b.nfiles;
+	}
+	pthread_mutex_init(&b.lock, NULL);
+	threads=malloc(jobs*sizeof(pthread_t));
+	if(threads==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+
+	/*Convert*/
+	start=batch_now();
+	for(int i=0; i < jobs; i++){
+		if(pthread_create(&threads[i], NULL, batch_worker, &b)!=0){
+			dbgprintf(0,"Error: Couldn't create thread\n");
+			exit(1);
+		}
+	}
+	for(int i=0; i < jobs; i++){
+		pthread_join(threads[i], NULL);
+	}
+	secs=batch_now() - start;
+
+	/*Summary*/
+	dbgprintf(0,"%-32s %10s %10s %8s %6s %9s %12s\n", "file", "packets", "converted",
+			"warnings", "conns", "seconds", "packets/s");
+	for(int i=0; i < b.nfiles; i++){
+		struct batch_file *f=&b.files[i];
+
+		if(f->failed){
+			dbgprintf(0,"%-32s failed\n", f->in);
+			failed++;
+		}else{
+			dbgprintf(0,"%-32s %10llu %10llu %8llu %6i %9.3f %12.0f\n", f->in,
+					(unsigned long long)f->packets, (unsigned long long)f->converted,
+					(unsigned long long)f->warnings, f->conns, f->secs,
+					f->secs > 0 ? f->packets/f->secs : 0);
+		}
+		packets+=f->packets;
+		free(f->in);
+		free(f->stem);
+	}
+	dbgprintf(0,"Total: %i files (%i failed), %llu packets in %.3f s (%.0f packets/s) on %i threads\n",
+			b.nfiles, failed, (unsigned long long)packets, secs, secs > 0 ? packets/secs : 0, jobs);
+
+	pthread_mutex_destroy(&b.lock);
+	free(threads);
+	free(b.files);
+return failed;
+}
+
+/*Worker thread: convert files until there are none left*/
+void *batch_worker(void *arg)
+{
+	struct batch	*b=(struct batch*)arg;
+	int				i;
+
+	while(1){
+		pthread_mutex_lock(&b->lock);
+		i=b->next++;
+		pthread_mutex_unlock(&b->lock);
+		if(i >= b->nfiles){
+			break;
+		}
+		batch_file(b, &b->files[i]);
+	}
+return NULL;
+}
+
+/*Convert one file in a new context*/
+void batch_file(struct batch *b, struct batch_file *f)
+{
+	char				ebuf[PCAP_ERRBUF_SIZE];
+	pcap_t				*in;
+	struct d2t_ctx		*ctx;
+	struct batch_count	cnt;
+	FILE				*sfile=NULL;
+	FILE				*gfile=NULL;
+	char				*tfile;
+	char				*gname=NULL;
+	char				*xplot=NULL;
+	char				*columns=NULL;
+	double				start;
+
+	start=batch_now();
+	in=pcap_open_offline(f->in, ebuf);
+	if(in==NULL){
+		dbgprintf(0,"Error opening input file %s: %s\n", f->in, ebuf);
+		f->failed=1;
+		return;
+	}
+
+	/*Same options as the command line, new state*/
+	ctx=ctx_new();
+	ctx->debug=b->opts->debug;
+	ctx->yellow=b->opts->yellow;
+	ctx->green=b->opts->green;
+	ctx->sack=b->opts->sack;
+	ctx->stats=b->opts->stats;
+	ctx->xplot_points=b->opts->xplot_points;
+	ctx->nopcap=b->opts->nopcap;
+	ctx->headers_only=b->opts->headers_only;
+	ctx->filter=b->opts->filter;
+	ctx->link=pcap_datalink(in);
+	if(ctx->filter && (ctx->filter->min_pkts || ctx->filter->min_bytes) && !filter_count(ctx, f->in)){
+		f->failed=1;
+	}
+
+	/*Outputs*/
+	tfile=batch_path(b->outdir, f->stem, ctx->stats ? batch_stats_name(ctx) : "tcp.pcap");
+	if(b->opts->xplot){
+		ctx->xplot=xplot=batch_path(b->outdir, f->stem, b->opts->xplot);
+	}
+	if(b->opts->columns){
+		ctx->columns=columns=batch_path(b->outdir, f->stem, b->opts->columns);
+		if(!columns_open(columns)){
+			f->failed=1;
+		}
+	}
+	if(ctx->stats){
+		sfile=fopen(tfile,"w");
+		if(sfile==NULL){
+			dbgprintf(0,"Error opening output file %s\n", tfile);
+			f->failed=1;
+		}
+		if(ctx->stats==STATS_CSV){
+			gname=batch_goodput_name(tfile);
+			gfile=fopen(gname,"w");
+			if(gfile==NULL){
+				dbgprintf(0,"Error opening output file %s\n", gname);
+				f->failed=1;
+			}
+		}
+	}else if(!ctx->nopcap){
+		ctx->out=pcap_dump_open(in, tfile);
+		if(ctx->out==NULL){
+			dbgprintf(0,"Error opening output file %s\n", tfile);
+			f->failed=1;
+		}
+	}
+
+	/*Convert*/
+	if(!f->failed){
+		cnt.ctx=ctx;
+		cnt.packets=cnt.converted=0;
+		pcap_loop(in, -1, batch_packet, (u_char*)&cnt);
+		f->packets=cnt.packets;
+		f->converted=cnt.converted;
+	}
+	pcap_close(in);
+	if(!ctx_finish(ctx)){
+		f->failed=1;
+	}
+	if(sfile){
+		stats_print(sfile, gfile, ctx->stats);
+		fclose(sfile);
+	}else if(ctx->out){
+		pcap_dump_close(ctx->out);
+	}
+	if(gfile){
+		fclose(gfile);
+	}
+
+	for(int w=0; w < NUM_WARN; w++){
+		f->warnings+=ctx->warn_total[w];
+	}
+	f->conns=ctx->num_hcons/2;
+	ctx_free(ctx);
+	free(tfile);
+	free(gname);
+	free(xplot);
+	free(columns);
+	f->secs=batch_now() - start;
+}
+
+/*call back function for pcap_loop--convert a packet and count it*/
+void batch_packet(u_char *user, const struct pcap_pkthdr *h, const u_char *bytes)
+{
+	struct batch_count	*cnt=(struct batch_count*)user;
+	struct d2t_pkt		pkt;
+
+	cnt->packets++;
+	if(!ctx_convert(cnt->ctx, h, bytes, &pkt)){
+		return;
+	}
+	cnt->converted++;
+	if(cnt->ctx->out){
+		dump_packet(cnt->ctx->out, &pkt);
+	}
+}
+
+/*Add an input to the batch: a file, or every file in a directory (sorted by
+ * name, skipping hidden files). Returns 1 if it can't be read*/
+int batch_add(struct batch *b, char *in)
+{
+	struct stat		st;
+	DIR				*dir;
+	struct dirent	*ent;
+	char			*path;
+	char			*stem;
+	int				first;
+	int				ret=0;
+
+	if(stat(in, &st)!=0){
+		dbgprintf(0,"Error: Can't read %s\n", in);
+		return 1;
+	}
+	if(!S_ISDIR(st.st_mode)){
+		/*stem: base name without its extension*/
+		stem=strdup(strrchr(in,'/') ? strrchr(in,'/') + 1 : in);
+		path=strdup(in);
+		if(stem==NULL || path==NULL){
+			dbgprintf(0,"Error: Couldn't allocate Memory\n");
+			exit(1);
+		}
+		if(strrchr(stem,'.') && strrchr(stem,'.')!=stem){
+			*strrchr(stem,'.')=0;
+		}
+
+		/*each input needs its own outputs*/
+		for(int i=0; i < b->nfiles; i++){
+			if(strcmp(b->files[i].stem, stem)==0){
+				dbgprintf(0,"Error: %s and %s would both be written to %s/%s.*\n",
+						b->files[i].in, in, b->outdir, stem);
+				free(stem);
+				free(path);
+				b->clash=1;
+				return 1;
+			}
+		}
+
+		b->files=realloc(b->files, (b->nfiles + 1)*sizeof(struct batch_file));
+		if(b->files==NULL){
+			dbgprintf(0,"Error: Couldn't allocate Memory\n");
+			exit(1);
+		}
+		memset(&b->files[b->nfiles], 0, sizeof(struct batch_file));
+		b->files[b->nfiles].in=path;
+		b->files[b->nfiles].stem=stem;
+		b->files[b->nfiles].dev=st.st_dev;
+		b->files[b->nfiles].ino=st.st_ino;
+		b->nfiles++;
+		return 0;
+	}
+
+	dir=opendir(in);
+	if(dir==NULL){
+		dbgprintf(0,"Error: Can't read %s\n", in);
+		return 1;
+	}
+	first=b->nfiles;
+	while((ent=readdir(dir))!=NULL){
+		if(ent->d_name[0]=='.'){
+			continue;
+		}
+		path=batch_path(in, ent->d_name, NULL);
+		if(stat(path, &st)==0 && S_ISREG(st.st_mode)){
+			ret|=batch_add(b, path);
+		}
+		free(path);
+	}
+	closedir(dir);
+	qsort(b->files + first, b->nfiles - first, sizeof(struct batch_file), batch_cmp);
+return ret;
+}
+
+/*Refuse to convert if an output would overwrite one of the inputs. Returns
+ * 1 if one would*/
+int batch_check(struct batch *b)
+{
+	char	*path;
+	char	*gpath;
+	int		ret=0;
+
+	for(int i=0; i < b->nfiles; i++){
+		path=batch_path(b->outdir, b->files[i].stem,
+				b->opts->stats ? batch_stats_name(b->opts) : "tcp.pcap");
+		ret|=batch_clash(b, &b->files[i], path);
+		if(b->opts->stats==STATS_CSV){
+			gpath=batch_goodput_name(path);
+			ret|=batch_clash(b, &b->files[i], gpath);
+			free(gpath);
+		}
+		free(path);
+		if(b->opts->columns){
+			path=batch_path(b->outdir, b->files[i].stem, b->opts->columns);
+			ret|=batch_clash(b, &b->files[i], path);
+			free(path);
+		}
+	}
+return ret;
+}
+
+/*Returns 1 (with a message) if path, an output of f, is one of the inputs*/
+int batch_clash(struct batch *b, struct batch_file *f, const char *path)
+{
+	struct stat		st;
+
+	if(stat(path, &st)!=0){
+		return 0;
+	}
+	for(int i=0; i < b->nfiles; i++){
+		if(b->files[i].dev==st.st_dev && b->files[i].ino==st.st_ino){
+			dbgprintf(0,"Error: Output %s of %s would overwrite the input %s\n",
+					path, f->in, b->files[i].in);
+			return 1;
+		}
+	}
+return 0;
+}
+
+/*Return dir/name, or dir/name.suffix, in a new string*/
+char *batch_path(const char *dir, const char *name, const char *suffix)
+{
+	char	*path;
+	int		len;
+
+	len=strlen(dir) + strlen(name) + (suffix ? strlen(suffix) : 0) + 3;
+	path=malloc(len);
+	if(path==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+	if(suffix){
+		snprintf(path, len, "%s/%s.%s", dir, name, suffix);
+	}else{
+		snprintf(path, len, "%s/%s", dir, name);
+	}
+return path;
+}
+
+/*Suffix of a statistics output*/
+char *batch_stats_name(const struct d2t_ctx *opts)
+{
+	return opts->stats==STATS_JSON ? "stats.json" : "stats.csv";
+}
+
+/*Goodput table next to the CSV statistics file path*/
+char *batch_goodput_name(const char *path)
+{
+	char	*name;
+
+	name=stats_goodput_name(path);
+	if(name==NULL){
+		exit(1);
+	}
+return name;
+}
+
+/*Monotonic wall clock in seconds*/
+double batch_now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/*Order files by input name*/
+int batch_cmp(const void *a, const void *b)
+{
+return strcmp(((const struct batch_file*)a)->in, ((const struct batch_file*)b)->in);
+}
@@ -0,0 +1,50 @@
+#!/bin/sh
+###############################################################################
+#Author: dccp2tcp contributors
+#
+# Date: 10/2026
+#
+# Benchmark dccp2tcp over a matrix of synthetic captures. Run by "make bench".
+#	bench.sh dccp2tcp gencap data_dir
+# Each case is generated once (the generator is deterministic) and converted
+# with --profile, which gives packets/s and the peak resident set size.
+###############################################################################
+
+D2T=${1:-./dccp2tcp}
+GEN=${2:-./bench/gencap}
+DIR=${3:-./bench/data}
+
+mkdir -p "$DIR" || exit 1
+
+# name:gencap options:dccp2tcp options
+CASES="
+base:-c 10 -n 20000:
+sack:-c 10 -n 20000 -l 1 -b 3:-s
+yellow:-c 10 -n 20000 -l 1 -b 3:-y
+conns100:-c 100 -n 2000:
+conns2000:-c 2000 -n 100:
+loss5:-c 10 -n 20000 -l 5 -b 2 -w 256:-s
+dense_acks:-c 10 -n 20000 -a 1:
+sparse_acks:-c 10 -n 20000 -a 16 -w 256:
+ipv6:-c 10 -n 20000 -6 100:
+mixed_vlan:-c 100 -n 2000 -6 50 -L vlan:
+sll:-c 10 -n 20000 -L sll:
+small_pkts:-c 10 -n 20000 -p 100:
+jumbo:-c 10 -n 5000 -p 8900:
+stats:-c 100 -n 2000 -l 1:--stats
+"
+
+printf "%-12s %10s %9s %12s %10s\n" "case" "packets" "seconds" "packets/s" "max RSS kB"
+echo "$CASES" | while IFS=: read name gopts dopts; do
+	[ -z "$name" ] && continue
+	cap="$DIR/$name.pcap"
+	if [ ! -f "$cap" ]; then
+		$GEN $gopts "$cap" 2>/dev/null || { echo "$name: gencap failed"; exit 1; }
+	fi
+	$D2T --profile $dopts "$cap" /dev/null 2>"$DIR/$name.prof" || { echo "$name: dccp2tcp failed"; exit 1; }
+	awk -v name="$name" '
+		/^Profile:/ { pkts=$2; secs=$5; rate=$7; sub(/^\(/,"",rate) }
+		/^Max resident set size:/ { rss=$5 }
+		END { printf "%-12s %10s %9s %12s %10s\n", name, pkts, secs, rate, rss }
+	' "$DIR/$name.prof"
+done
@@ -0,0 +1,568 @@
+/******************************************************************************
+Synthetic DCCP capture generator for benchmarking dccp2tcp.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	1)Writes a pcap file of concurrent CCID 2 connections, as captured at the
+		senders: Request, Response, Ack, then Data/DataAck packets from the
+		client, each answered by Acks with Ack Vectors from the server, then
+		Close and Reset.
+	2)"Lost" data packets are still in the capture, the server's Ack Vectors
+		report them as not received.
+	3)Output only depends on the options (including the seed), so the same
+		command line always gives the same file.
+	4)Doesn't need libpcap, the file is written directly.
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <arpa/inet.h>
+#include "../checksums.h"
+
+#define PCAP_MAGIC		0xa1b2c3d4
+#define DLT_EN10MB		1
+#define DLT_LINUX_SLL	113
+#define ETH_HDR_LEN		14
+#define VLAN_TAG_LEN	4
+#define SLL_HDR_LEN		16
+#define IP4_HDR_LEN		20
+#define IP6_HDR_LEN		40
+#define MAX_OPTS		256		/*Room for DCCP options*/
+#define MAX_PAYLOAD		65000	/*Largest payload (-p)*/
+#define AV_RING			4096	/*Loss history kept per connection*/
+#define BASE_TIME		1360000000	/*Timestamp of the first packet*/
+
+/*DCCP packet types*/
+enum{
+	PKT_REQUEST=0,
+	PKT_RESPONSE=1,
+	PKT_DATA=2,
+	PKT_ACK=3,
+	PKT_DATAACK=4,
+	PKT_CLOSE=6,
+	PKT_RESET=7,
+};
+
+/*Link types*/
+enum link{
+	LINK_ETH,
+	LINK_VLAN,
+	LINK_SLL,
+};
+
+/*Connection states*/
+enum gstate{
+	G_REQUEST,
+	G_RESPONSE,
+	G_ACK,
+	G_DATA,
+	G_CLOSE,
+	G_RESET,
+	G_DONE,
+};
+
+/*A generated connection. Host A is the client and data sender*/
+struct gconn{
+	int				v6;				/*IPv6?*/
+	u_char			a_addr[16];		/*Client address*/
+	u_char			b_addr[16];		/*Server address*/
+	u_int16_t		a_port;			/*Client port*/
+	u_int16_t		b_port;			/*Server port*/
+	u_int64_t		a_seq;			/*Last sequence number sent by A*/
+	u_int64_t		b_seq;			/*Last sequence number sent by B*/
+	u_int64_t		a_first;		/*First data sequence number of A*/
+	enum gstate		state;			/*Next packet to send*/
+	int				sent;			/*Data packets sent*/
+	int				unacked;		/*Data packets since B's last Ack*/
+	int				b_acked;		/*B sent an Ack A hasn't acknowledged*/
+	int				burst;			/*Packets left in the current loss burst*/
+	u_char			lost[AV_RING];	/*Loss state of A's recent packets*/
+};
+
+/*Generator options*/
+static int			conns=10;		/*Number of connections*/
+static int			flow_len=10000;	/*Data packets per connection*/
+static int			loss_pct=0;		/*Loss probability, in 1/100 percent*/
+static int			loss_burst=1;	/*Packets lost per loss event*/
+static int			ack_every=2;	/*Data packets per Ack*/
+static int			av_window=64;	/*Packets covered by an Ack Vector*/
+static int			v6_pct=0;		/*Percent of IPv6 connections*/
+static enum link	link_type=LINK_ETH;
+static int			payload=1400;	/*Data payload size*/
+static int			interval=100;	/*Microseconds between packets*/
+static int			snaplen=65535;	/*Bytes of each packet captured*/
+static u_int64_t	seed=1;			/*PRNG seed*/
+
+static FILE			*out;
+static u_int64_t	pkt_time=0;		/*Microseconds since BASE_TIME*/
+static u_int64_t	pkts=0;			/*Packets written*/
+static u_char		pkt_buf[ETH_HDR_LEN + VLAN_TAG_LEN + SLL_HDR_LEN + IP6_HDR_LEN + 64
+						+ MAX_OPTS + MAX_PAYLOAD];
+
+void usage();
+u_int64_t rnd();
+void gen_init(struct gconn *c, int i);
+void gen_step(struct gconn *c);
+void send_dccp(struct gconn *c, int from_a, int type, const u_char *opts, int optlen, int datalen);
+int ack_vector(struct gconn *c, u_char *opts);
+
+
+int main(int argc, char *argv[])
+{
+	struct gconn	*cs;
+	int				*active;
+	int				nactive;
+	int				i;
+	int				opt;
+	struct{
+		u_int32_t	magic;
+		u_int16_t	major;
+		u_int16_t	minor;
+		int32_t		zone;
+		u_int32_t	sigfigs;
+		u_int32_t	snaplen;
+		u_int32_t	linktype;
+	}				hdr;
+
+	while((opt=getopt(argc, argv, "c:n:l:b:a:w:6:L:p:t:s:S:h")) != -1){
+		switch(opt){
+			case 'c':
+				conns=atoi(optarg);
+				break;
+			case 'n':
+				flow_len=atoi(optarg);
+				break;
+			case 'l':
+				loss_pct=(int)(atof(optarg)*100);
+				break;
+			case 'b':
+				loss_burst=atoi(optarg);
+				break;
+			case 'a':
+				ack_every=atoi(optarg);
+				break;
+			case 'w':
+				av_window=atoi(optarg);
+				break;
+			case '6':
+				v6_pct=atoi(optarg);
+				break;
+			case 'L':
+				if(strcmp(optarg,"eth")==0){
+					link_type=LINK_ETH;
+				}else if(strcmp(optarg,"vlan")==0){
+					link_type=LINK_VLAN;
+				}else if(strcmp(optarg,"sll")==0){
+					link_type=LINK_SLL;
+				}else{
+					usage();
+				}
+				break;
+			case 'p':
+				payload=atoi(optarg);
+				break;
+			case 't':
+				interval=atoi(optarg);
+				break;
+			case 's':
+				seed=strtoull(optarg, NULL, 0);
+				break;
+			case 'S':
+				snaplen=atoi(optarg);
+				break;
+			default:
+				usage();
+		}
+	}
+	if(optind != argc - 1 || conns < 1 || flow_len < 1 || ack_every < 1 || loss_burst < 1
+			|| av_window < 1 || av_window >= AV_RING || payload < 0 || payload > MAX_PAYLOAD || snaplen < 1){
+		usage();
+	}
+	if(seed==0){
+		seed=1;
+	}
+
+	out=strcmp(argv[optind],"-")==0 ? stdout : fopen(argv[optind],"wb");
+	if(out==NULL){
+		fprintf(stderr, "Error opening output file %s\n", argv[optind]);
+		exit(1);
+	}
+
+	/*pcap file header*/
+	hdr.magic=PCAP_MAGIC;
+	hdr.major=2;
+	hdr.minor=4;
+	hdr.zone=0;
+	hdr.sigfigs=0;
+	hdr.snaplen=snaplen;
+	hdr.linktype= link_type==LINK_SLL ? DLT_LINUX_SLL : DLT_EN10MB;
+	fwrite(&hdr, sizeof(hdr), 1, out);
+
+	/*Connections*/
+	cs=calloc(conns, sizeof(struct gconn));
+	active=malloc(conns*sizeof(int));
+	if(cs==NULL || active==NULL){
+		fprintf(stderr, "Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+	for(i=0; i < conns; i++){
+		gen_init(&cs[i], i);
+		active[i]=i;
+	}
+
+	/*Advance a random active connection by one packet until all are done*/
+	nactive=conns;
+	while(nactive > 0){
+		i=rnd()%nactive;
+		gen_step(&cs[active[i]]);
+		if(cs[active[i]].state==G_DONE){
+			active[i]=active[--nactive];
+		}
+	}
+
+	if(fclose(out)!=0){
+		fprintf(stderr, "Error writing output file\n");
+		exit(1);
+	}
+	fprintf(stderr, "%llu packets\n", (unsigned long long)pkts);
+	free(cs);
+	free(active);
+return 0;
+}
+
+/*xorshift64* PRNG*/
+u_int64_t rnd()
+{
+	seed^=seed >> 12;
+	seed^=seed << 25;
+	seed^=seed >> 27;
+return seed * 2685821657736338717ULL;
+}
+
+/*Set up connection i*/
+void gen_init(struct gconn *c, int i)
+{
+	memset(c, 0, sizeof(struct gconn));
+	c->v6= (int)(rnd()%100) < v6_pct;
+	if(c->v6){
+		/*fd00::<i+1> to fd00::ffff:0*/
+		c->a_addr[0]=c->b_addr[0]=0xfd;
+		c->a_addr[12]=((i+1) >> 24) & 0xFF;
+		c->a_addr[13]=((i+1) >> 16) & 0xFF;
+		c->a_addr[14]=((i+1) >> 8) & 0xFF;
+		c->a_addr[15]=(i+1) & 0xFF;
+		c->b_addr[12]=c->b_addr[13]=0xff;
+	}else{
+		/*10.x.y.z to 192.168.0.1*/
+		c->a_addr[0]=10;
+		c->a_addr[1]=((i+1) >> 16) & 0xFF;
+		c->a_addr[2]=((i+1) >> 8) & 0xFF;
+		c->a_addr[3]=(i+1) & 0xFF;
+		c->b_addr[0]=192;
+		c->b_addr[1]=168;
+		c->b_addr[3]=1;
+	}
+	c->a_port=40000 + i%20000;
+	c->b_port=5001;
+	c->a_seq=(rnd() & 0xFFFFFFFFFFFFULL) - 1;
+	c->b_seq=(rnd() & 0xFFFFFFFFFFFFULL) - 1;
+	c->state=G_REQUEST;
+}
+
+/*Send the next packet of connection c*/
+void gen_step(struct gconn *c)
+{
+	u_char	opts[MAX_OPTS];
+	int		optlen;
+	int		lost;
+	/*Change L/R CCID 2 in the Request, Confirm L/R CCID 2 in the Response*/
+	static const u_char ccid_change[8]={32,4,1,2,34,4,1,2};
+	static const u_char ccid_confirm[8]={33,4,1,2,35,4,1,2};
+
+	switch(c->state){
+		case G_REQUEST:
+			send_dccp(c, 1, PKT_REQUEST, ccid_change, sizeof(ccid_change), 0);
+			c->state=G_RESPONSE;
+			break;
+		case G_RESPONSE:
+			send_dccp(c, 0, PKT_RESPONSE, ccid_confirm, sizeof(ccid_confirm), 0);
+			c->state=G_ACK;
+			break;
+		case G_ACK:
+			send_dccp(c, 1, PKT_ACK, NULL, 0, 0);
+			c->a_first=c->a_seq + 1;
+			c->state=G_DATA;
+			break;
+		case G_DATA:
+			/*Server Ack with an Ack Vector*/
+			if(c->unacked >= ack_every || (c->sent==flow_len && c->unacked > 0)){
+				optlen=ack_vector(c, opts);
+				send_dccp(c, 0, PKT_ACK, opts, optlen, 0);
+				c->unacked=0;
+				c->b_acked=1;
+				break;
+			}
+			if(c->sent==flow_len){
+				c->state=G_CLOSE;
+				gen_step(c);
+				break;
+			}
+
+			/*Client data, acknowledging the server's Acks if needed*/
+			lost=0;
+			if(c->burst > 0){
+				c->burst--;
+				lost=1;
+			}else if(loss_pct > 0 && (int)(rnd()%10000) < loss_pct){
+				c->burst=loss_burst - 1;
+				lost=1;
+			}
+			send_dccp(c, 1, c->b_acked ? PKT_DATAACK : PKT_DATA, NULL, 0, payload);
+			c->lost[c->a_seq%AV_RING]=lost;
+			c->b_acked=0;
+			c->sent++;
+			c->unacked++;
+			break;
+		case G_CLOSE:
+			send_dccp(c, 1, PKT_CLOSE, NULL, 0, 0);
+			c->state=G_RESET;
+			break;
+		case G_RESET:
+			send_dccp(c, 0, PKT_RESET, NULL, 0, 0);
+			c->state=G_DONE;
+			break;
+		case G_DONE:
+			break;
+	}
+}
+
+/*Build an Ack Vector option for A's packets, newest first, padded to
+ * a multiple of 4 bytes. Returns the option length*/
+int ack_vector(struct gconn *c, u_char *opts)
+{
+	u_int64_t	seq=c->a_seq;
+	int			left=av_window;
+	int			len=2;
+	int			state;
+	int			run;
+
+	while(left > 0 && len < 253){
+		state= seq >= c->a_first && c->lost[seq%AV_RING] ? 3 : 0;
+		run=1;
+		while(run < left && run < 64
+				&& (seq - run >= c->a_first && c->lost[(seq - run)%AV_RING] ? 3 : 0)==state){
+			run++;
+		}
+		opts[len++]=(state << 6) | (run - 1);
+		seq-=run;
+		left-=run;
+	}
+	opts[0]=38;
+	opts[1]=len;
+	while(len%4){
+		opts[len++]=0;
+	}
+return len;
+}
+
+/*Write a DCCP packet with the given options and payload length from A
+ * (or B) of connection c to the output file*/
+void send_dccp(struct gconn *c, int from_a, int type, const u_char *opts, int optlen, int datalen)
+{
+	u_char		*pkt=pkt_buf;
+	u_char		*ip;
+	u_char		*dccp;
+	u_char		*src;
+	u_char		*dst;
+	u_int64_t	seq;
+	u_int64_t	ack;
+	int			hdrlen;
+	int			dccplen;
+	int			len;
+	u_int16_t	ethertype;
+	u_int16_t	sum;
+	struct{
+		int32_t		tv_sec;
+		int32_t		tv_usec;
+		u_int32_t	caplen;
+		u_int32_t	len;
+	}			rec;
+
+	if(from_a){
+		seq=++c->a_seq;
+		ack=c->b_seq;
+		src=c->a_addr;
+		dst=c->b_addr;
+	}else{
+		seq=++c->b_seq;
+		ack=c->a_seq;
+		src=c->b_addr;
+		dst=c->a_addr;
+	}
+	ethertype= c->v6 ? 0x86DD : 0x0800;
+
+	/*Link layer*/
+	switch(link_type){
+		case LINK_ETH:
+		case LINK_VLAN:
+			memset(pkt, 0, ETH_HDR_LEN);
+			pkt[0]=0x02;	/*locally administered MACs*/
+			pkt[5]=from_a ? 2 : 1;
+			pkt[6]=0x02;
+			pkt[11]=from_a ? 1 : 2;
+			if(link_type==LINK_VLAN){
+				pkt[12]=0x81;
+				pkt[13]=0x00;
+				pkt[14]=0;		/*VLAN 10*/
+				pkt[15]=10;
+				pkt[16]=ethertype >> 8;
+				pkt[17]=ethertype & 0xFF;
+				ip=pkt + ETH_HDR_LEN + VLAN_TAG_LEN;
+			}else{
+				pkt[12]=ethertype >> 8;
+				pkt[13]=ethertype & 0xFF;
+				ip=pkt + ETH_HDR_LEN;
+			}
+			break;
+		case LINK_SLL:
+		default:
+			memset(pkt, 0, SLL_HDR_LEN);
+			pkt[1]=from_a ? 4 : 0;	/*outgoing or to us*/
+			pkt[3]=1;				/*Ethernet*/
+			pkt[5]=6;
+			pkt[6]=0x02;
+			pkt[11]=from_a ? 1 : 2;
+			pkt[14]=ethertype >> 8;
+			pkt[15]=ethertype & 0xFF;
+			ip=pkt + SLL_HDR_LEN;
+			break;
+	}
+	dccp=ip + (c->v6 ? IP6_HDR_LEN : IP4_HDR_LEN);
+
+	/*DCCP generic header with 48 bit sequence numbers*/
+	switch(type){
+		case PKT_REQUEST:
+			hdrlen=20;	/*+Service Code*/
+			break;
+		case PKT_DATA:
+			hdrlen=16;
+			break;
+		case PKT_RESPONSE:
+		case PKT_RESET:
+			hdrlen=28;	/*+Ack Number, Service Code or Reset Code*/
+			break;
+		default:
+			hdrlen=24;	/*+Ack Number*/
+			break;
+	}
+	memset(dccp, 0, hdrlen);
+	dccp[0]=(from_a ? c->a_port : c->b_port) >> 8;
+	dccp[1]=(from_a ? c->a_port : c->b_port) & 0xFF;
+	dccp[2]=(from_a ? c->b_port : c->a_port) >> 8;
+	dccp[3]=(from_a ? c->b_port : c->a_port) & 0xFF;
+	dccp[4]=(hdrlen + optlen)/4;
+	dccp[8]=(type << 1) | 1;
+	dccp[10]=(seq >> 40) & 0xFF;
+	dccp[11]=(seq >> 32) & 0xFF;
+	dccp[12]=(seq >> 24) & 0xFF;
+	dccp[13]=(seq >> 16) & 0xFF;
+	dccp[14]=(seq >> 8) & 0xFF;
+	dccp[15]=seq & 0xFF;
+	if(hdrlen >= 24){
+		dccp[18]=(ack >> 40) & 0xFF;
+		dccp[19]=(ack >> 32) & 0xFF;
+		dccp[20]=(ack >> 24) & 0xFF;
+		dccp[21]=(ack >> 16) & 0xFF;
+		dccp[22]=(ack >> 8) & 0xFF;
+		dccp[23]=ack & 0xFF;
+	}
+	if(type==PKT_REQUEST || type==PKT_RESPONSE){
+		dccp[hdrlen - 1]=42;	/*Service Code*/
+	}
+	if(type==PKT_RESET){
+		dccp[24]=1;				/*Closed*/
+	}
+	if(optlen){
+		memcpy(dccp + hdrlen, opts, optlen);
+	}
+	for(int i=0; i < datalen; i++){
+		dccp[hdrlen + optlen + i]=(u_char)(seq + i);
+	}
+	dccplen=hdrlen + optlen + datalen;
+
+	/*IP header*/
+	if(c->v6){
+		memset(ip, 0, IP6_HDR_LEN);
+		ip[0]=0x60;
+		ip[4]=dccplen >> 8;
+		ip[5]=dccplen & 0xFF;
+		ip[6]=33;	/*DCCP*/
+		ip[7]=64;
+		memcpy(ip + 8, src, 16);
+		memcpy(ip + 24, dst, 16);
+		sum=ipv6_pseudohdr_chksum(dccp, dccplen, dst, src, 33);
+	}else{
+		memset(ip, 0, IP4_HDR_LEN);
+		ip[0]=0x45;
+		ip[2]=(IP4_HDR_LEN + dccplen) >> 8;
+		ip[3]=(IP4_HDR_LEN + dccplen) & 0xFF;
+		ip[6]=0x40;	/*Don't Fragment*/
+		ip[8]=64;
+		ip[9]=33;	/*DCCP*/
+		memcpy(ip + 12, src, 4);
+		memcpy(ip + 16, dst, 4);
+		sum=ipv4_chksum(ip, IP4_HDR_LEN);
+		memcpy(ip + 10, &sum, 2);
+		sum=ipv4_pseudohdr_chksum(dccp, dccplen, dst, src, 33);
+	}
+	memcpy(dccp + 6, &sum, 2);
+
+	/*pcap record*/
+	len=dccp + dccplen - pkt;
+	rec.tv_sec=BASE_TIME + pkt_time/1000000;
+	rec.tv_usec=pkt_time%1000000;
+	rec.caplen= len < snaplen ? len : snaplen;
+	rec.len=len;
+	fwrite(&rec, sizeof(rec), 1, out);
+	fwrite(pkt, 1, rec.caplen, out);
+	pkt_time+=interval;
+	pkts++;
+}
+
+/*Usage information*/
+void usage()
+{
+	fprintf(stderr, "Usage: gencap [options] out_file\n"
+		"  -c N     connections, all open at once (10)\n"
+		"  -n N     data packets per connection (10000)\n"
+		"  -l P     loss probability of data packets, percent (0)\n"
+		"  -b N     packets lost per loss event (1)\n"
+		"  -a N     data packets per Ack (2)\n"
+		"  -w N     packets covered by each Ack Vector (64)\n"
+		"  -6 P     percent of IPv6 connections (0)\n"
+		"  -L link  eth, vlan or sll (eth)\n"
+		"  -p N     payload bytes per data packet (1400)\n"
+		"  -t N     microseconds between packets (100)\n"
+		"  -s N     random seed (1)\n"
+		"  -S N     snaplen, bytes of each packet captured (65535)\n");
+	exit(1);
+}
@@ -0,0 +1,425 @@
+/******************************************************************************
+Micro-benchmarks for the per-packet kernels of dccp2tcp.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	1)Linked against libdccp2tcp, like dccp2tcp, so the kernels measured
+		are the ones the converter runs.
+	2)Usage: microbench [scale [capture]]. scale multiplies the iteration
+		counts. With a capture, whole-packet conversion of it is timed too,
+		one packet at a time and in batches.
+	3)Cycles are TSC cycles on x86, elsewhere only ns/op is reported.
+******************************************************************************/
+#include "../dccp2tcp.h"
+
+#define SRC_IP		"\x0a\x00\x00\x01"
+#define DST_IP		"\xc0\xa8\x00\x01"
+#define DCCP_ACK_HDR	(sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext) \
+						+ sizeof(struct dccp_hdr_ack_bits))
+#define MAX_SEG		65000
+
+static double				scale=1;		/*Iteration multiplier*/
+static volatile u_int32_t	sink;			/*Keeps results alive*/
+static u_char				seg[MAX_SEG];	/*Segment to checksum*/
+static u_char				hdr[DCCP_ACK_HDR + 256];	/*DCCP Ack with an Ack Vector*/
+static struct ack_vect		av;				/*hdr's Ack Vector, decoded*/
+static u_int64_t			t_ns;			/*Start of the current measurement*/
+static u_int64_t			t_cyc;
+
+void bench_checksum();
+void bench_ack_vect();
+void bench_add_new_seq();
+void bench_convert_ack();
+void bench_capture(const char *fname);
+int build_ack_vect(d_seq_num ack, int len, int loss);
+struct connection *new_conn(d_seq_num first, int fill, int reorder);
+
+
+/*Current time in nanoseconds*/
+static u_int64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+return (u_int64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+/*Cycle counter, 0 if there isn't one*/
+static inline u_int64_t now_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/*Start a measurement*/
+static void start()
+{
+	t_ns=now_ns();
+	t_cyc=now_cycles();
+}
+
+/*End a measurement of ops operations and print it*/
+static void stop(const char *kernel, const char *params, u_int64_t ops)
+{
+	u_int64_t	cyc=now_cycles() - t_cyc;
+	u_int64_t	ns=now_ns() - t_ns;
+
+	if(cyc){
+		printf("%-18s %-28s %10llu %10.1f %10.1f\n", kernel, params, (unsigned long long)ops,
+				(double)ns/ops, (double)cyc/ops);
+	}else{
+		printf("%-18s %-28s %10llu %10.1f %10s\n", kernel, params, (unsigned long long)ops,
+				(double)ns/ops, "-");
+	}
+}
+
+/*Scaled iteration count*/
+static u_int64_t iters(u_int64_t n)
+{
+	n=n*scale;
+return n ? n : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	struct d2t_ctx	*ctx;
+
+	if(argc > 3 || (argc>=2 && (scale=atof(argv[1])) <= 0)){
+		fprintf(stderr, "Usage: microbench [scale [capture]]\n");
+		exit(1);
+	}
+
+	ctx=ctx_new();
+	printf("%-18s %-28s %10s %10s %10s\n", "kernel", "parameters", "ops", "ns/op", "cycles/op");
+	bench_checksum();
+	bench_ack_vect();
+	bench_add_new_seq();
+	bench_convert_ack();
+	ctx_free(ctx);
+	if(argc==3){
+		bench_capture(argv[2]);
+	}
+return 0;
+}
+
+/*TCP checksums over segment sizes, whole and split in header and payload*/
+void bench_checksum()
+{
+	static const int	sizes[]={64, 576, 1500, 9000, 65000};
+	char				params[64];
+	u_int64_t			n;
+
+	for(int i=0; i < MAX_SEG; i++){
+		seg[i]=i*7;
+	}
+
+	for(int s=0; s < sizeof(sizes)/sizeof(sizes[0]); s++){
+		n=iters(20000000/sizes[s]);
+		snprintf(params, sizeof(params), "%i bytes", sizes[s]);
+
+		start();
+		for(u_int64_t i=0; i < n; i++){
+			sink+=ipv4_pseudohdr_chksum(seg, sizes[s], (u_char*)DST_IP, (u_char*)SRC_IP, 6);
+		}
+		stop("ipv4_chksum", params, n);
+
+		start();
+		for(u_int64_t i=0; i < n; i++){
+			sink+=ipv4_pseudohdr_chksum_split(seg, 20, seg + 20, sizes[s] - 20,
+					(u_char*)DST_IP, (u_char*)SRC_IP, 6);
+		}
+		stop("ipv4_chksum_split", params, n);
+	}
+}
+
+/*Build a DCCP Ack in hdr acknowledging ack, with an Ack Vector of len bytes.
+ * With loss, every byte is a run of 8 received packets followed by a byte
+ * for 1 lost packet. Returns the number of packets the vector covers*/
+int build_ack_vect(d_seq_num ack, int len, int loss)
+{
+	struct dccp_hdr				*dccph;
+	struct dccp_hdr_ack_bits	*dccphack;
+	u_char						*opt;
+	int							pkts=0;
+	int							optlen=(2 + len + 3) & ~3;
+
+	memset(hdr, 0, sizeof(hdr));
+	dccph=(struct dccp_hdr*)hdr;
+	dccphack=(struct dccp_hdr_ack_bits*)(hdr + sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext));
+	dccph->dccph_type=DCCP_PKT_ACK;
+	dccph->dccph_x=1;
+	dccph->dccph_doff=(DCCP_ACK_HDR + optlen)/4;
+	dccphack->dccph_ack_nr_low=htonl(ack);
+
+	opt=hdr + DCCP_ACK_HDR;
+	opt[0]=38;
+	opt[1]=2 + len;
+	for(int i=0; i < len; i++){
+		if(loss && i%2){
+			opt[2+i]=(AV_LOST << 6);
+			pkts+=1;
+		}else if(loss){
+			opt[2+i]=7;
+			pkts+=8;
+		}else{
+			opt[2+i]=63;
+			pkts+=64;
+		}
+	}
+return pkts;
+}
+
+/*Ack Vector interpretation and conversion to SACK blocks*/
+void bench_ack_vect()
+{
+	static const int	lens[]={4, 16, 64, 252};
+	struct connection	*con;
+	u_char				tcp[60];
+	struct tcphdr		*tcph=(struct tcphdr*)tcp;
+	char				params[64];
+	u_int64_t			n;
+	int					pkts;
+
+	/*Sequence table covering every packet the vectors can acknowledge*/
+	con=new_conn(1000, 20000, 0);
+
+	for(int loss=0; loss < 2; loss++){
+		for(int l=0; l < sizeof(lens)/sizeof(lens[0]); l++){
+			n=iters(200000);
+			pkts=build_ack_vect(1000 + 19999, lens[l], loss);
+			snprintf(params, sizeof(params), "%i bytes, %i pkts%s", lens[l], pkts, loss ? ", loss" : "");
+
+			start();
+			for(u_int64_t i=0; i < n; i++){
+				decode_ack_vect(hdr, NULL, &av);
+				sink+=av.additional;
+			}
+			stop("decode_ack_vect", params, n);
+
+			if(!loss){
+				continue;
+			}
+			start();
+			for(u_int64_t i=0; i < n; i++){
+				memset(tcp, 0, sizeof(tcp));
+				tcph->doff=5;
+				decode_ack_vect(hdr, NULL, &av);
+				ack_vect2sack(&con->A, tcph, tcp + 20, &av, 1000 + 19999, &con->B);
+				sink+=tcph->doff;
+			}
+			stop("ack_vect2sack", params, n);
+		}
+	}
+}
+
+/*Get a connection whose A half has a table with fill entries starting at
+ * first. With reorder, every 16th pair of packets is swapped*/
+struct connection *new_conn(d_seq_num first, int fill, int reorder)
+{
+	static u_int32_t	addr=0;
+	struct connection	*con;
+	u_int32_t			a;
+	u_int32_t			b;
+	d_seq_num			seq;
+
+	a=htonl(0x0a000000 + ++addr);
+	b=htonl(0xc0a80001);
+	con=add_connection((u_char*)&a, (u_char*)&b, 4, htons(40000), htons(5001));
+	initialize_hcon(&con->A, first);
+	initialize_hcon(&con->B, 1);
+	for(int i=1; i < fill; i++){
+		seq=first + i;
+		if(reorder && i%16==14){
+			seq++;
+		}else if(reorder && i%16==15){
+			seq--;
+		}
+		add_new_seq(&con->A, seq, 1000, DCCP_PKT_DATA);
+	}
+return con;
+}
+
+/*Adding sequence numbers, in order and with gaps*/
+void bench_add_new_seq()
+{
+	struct connection	*con;
+	u_int64_t			n;
+	d_seq_num			seq;
+
+	n=iters(2000000);
+	con=new_conn(1, 1, 0);
+	seq=1;
+	start();
+	for(u_int64_t i=0; i < n; i++){
+		sink+=add_new_seq(&con->A, ++seq, 1000, DCCP_PKT_DATA);
+	}
+	stop("add_new_seq", "in order", n);
+
+	/*one packet in 10 missing (the gap is filled in the table)*/
+	con=new_conn(1, 1, 0);
+	seq=1;
+	start();
+	for(u_int64_t i=0; i < n; i++){
+		seq+= i%10==9 ? 2 : 1;
+		sink+=add_new_seq(&con->A, seq, 1000, DCCP_PKT_DATA);
+	}
+	stop("add_new_seq", "1 in 10 missing", n);
+}
+
+/*Ack conversion at different table fill levels and access patterns*/
+void bench_convert_ack()
+{
+	static const int	fills[]={100, 4000, 30000};	/*reordered tables grow 1/16 more*/
+	struct connection	*con;
+	char				params[64];
+	u_int64_t			n;
+	u_int64_t			r=1;
+
+	for(int f=0; f < sizeof(fills)/sizeof(fills[0]); f++){
+		n=iters(2000000);
+		con=new_conn(1000, fills[f], 0);
+
+		snprintf(params, sizeof(params), "fill %i, newest", fills[f]);
+		start();
+		for(u_int64_t i=0; i < n; i++){
+			sink+=convert_ack(&con->A, 1000 + fills[f] - 1, &con->B);
+		}
+		stop("convert_ack", params, n);
+
+		snprintf(params, sizeof(params), "fill %i, random", fills[f]);
+		start();
+		for(u_int64_t i=0; i < n; i++){
+			r=r*6364136223846793005ULL + 1442695040888963407ULL;
+			sink+=convert_ack(&con->A, 1000 + (r >> 33)%fills[f], &con->B);
+		}
+		stop("convert_ack", params, n);
+
+		/*Reordered packets break the direct index, lookups fall back
+		 * to searching around the last hit*/
+		con=new_conn(1000, fills[f], 1);
+		snprintf(params, sizeof(params), "fill %i, reordered", fills[f]);
+		start();
+		for(u_int64_t i=0; i < n; i++){
+			sink+=convert_ack(&con->A, 1000 + (i%fills[f]), &con->B);
+		}
+		stop("convert_ack", params, n);
+
+		/*Not in the table: full scan*/
+		n=iters(2000);
+		snprintf(params, sizeof(params), "fill %i, absent", fills[f]);
+		start();
+		for(u_int64_t i=0; i < n; i++){
+			sink+=convert_ack(&con->A, 999, &con->B);
+		}
+		stop("convert_ack", params, n);
+	}
+}
+
+/*Conversion of a whole capture, read into memory first, by ctx_convert()
+ * and by ctx_convert_batch() with several batch sizes*/
+void bench_capture(const char *fname)
+{
+	static const int		batches[]={1, 8, 32, 128};
+	char					ebuf[PCAP_ERRBUF_SIZE];
+	pcap_t					*in;
+	struct pcap_pkthdr		*h;
+	const u_char			*bytes;
+	struct pcap_pkthdr		*hdrs=NULL;
+	const struct pcap_pkthdr	**hp;
+	const u_char			**data=NULL;
+	struct d2t_pkt			out[128];
+	struct d2t_ctx			*ctx;
+	char					params[64];
+	int						link;
+	int						n=0;
+	u_int64_t				reps;
+
+	in=pcap_open_offline(fname, ebuf);
+	if(in==NULL){
+		fprintf(stderr, "Error opening %s: %s\n", fname, ebuf);
+		exit(1);
+	}
+	link=pcap_datalink(in);
+	while(pcap_next_ex(in, &h, &bytes)==1){
+		hdrs=realloc(hdrs, (n + 1)*sizeof(struct pcap_pkthdr));
+		data=realloc(data, (n + 1)*sizeof(u_char*));
+		if(hdrs==NULL || data==NULL || (data[n]=malloc(h->caplen))==NULL){
+			fprintf(stderr, "Error: Couldn't allocate Memory\n");
+			exit(1);
+		}
+		hdrs[n]=*h;
+		memcpy((u_char*)data[n], bytes, h->caplen);
+		n++;
+	}
+	pcap_close(in);
+	if(n==0){
+		return;
+	}
+	hp=malloc(n*sizeof(struct pcap_pkthdr*));
+	if(hp==NULL){
+		fprintf(stderr, "Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+	for(int i=0; i < n; i++){
+		hp[i]=&hdrs[i];
+	}
+
+	/*Every pass gets a new context, the capture is one trace*/
+	reps=iters(2000000)/n;
+	reps=reps ? reps : 1;
+	snprintf(params, sizeof(params), "%i pkts, single", n);
+	start();
+	for(u_int64_t r=0; r < reps; r++){
+		ctx=ctx_new();
+		ctx->link=link;
+		ctx->sack=2;
+		for(int i=0; i < n; i++){
+			sink+=ctx_convert(ctx, hp[i], data[i], &out[0]);
+		}
+		ctx_free(ctx);
+	}
+	stop("convert", params, reps*n);
+
+	for(int b=0; b < sizeof(batches)/sizeof(batches[0]); b++){
+		snprintf(params, sizeof(params), "%i pkts, batch %i", n, batches[b]);
+		start();
+		for(u_int64_t r=0; r < reps; r++){
+			ctx=ctx_new();
+			ctx->link=link;
+			ctx->sack=2;
+			for(int i=0; i < n; i+=batches[b]){
+				sink+=ctx_convert_batch(ctx, n - i < batches[b] ? n - i : batches[b],
+						hp + i, data + i, out);
+			}
+			ctx_free(ctx);
+		}
+		stop("convert_batch", params, reps*n);
+	}
+
+	for(int i=0; i < n; i++){
+		free((u_char*)data[i]);
+	}
+	free(data);
+	free(hdrs);
+	free(hp);
+}
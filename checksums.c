@@ -54,7 +54,7 @@ u_int32_t checksum(u_char *buf, unsigned nbytes, u_int32_t sum)
 	int i;
 	/* Checksum all the pairs of bytes first... */
 	for (i = 0; i < (nbytes & ~1U); i += 2) {
-		sum += (u_int16_t)ntohs(*((u_int16_t *)(buf + i)));
+		sum += (buf[i] << 8) | buf[i + 1];	/*big-endian pair, no u_int16_t* aliasing*/
 		if (sum > 0xFFFF)
 			sum -= 0xFFFF;
 	}
@@ -80,7 +80,19 @@ u_int32_t wrapsum(u_int32_t sum)
 }
 
 u_int16_t ipv6_pseudohdr_chksum(u_char* buff, int len, u_char* dest, u_char* src, int type){
+	return ipv6_pseudohdr_chksum_split(buff, len, NULL, 0, dest, src, type);
+}
+
+u_int16_t ipv4_pseudohdr_chksum(u_char* buff, int len, u_char* dest, u_char* src, int type){
+	return ipv4_pseudohdr_chksum_split(buff, len, NULL, 0, dest, src, type);
+}
+
+/*Checksum a packet stored in two pieces: a header and data.
+ * hdrlen MUST be even if there is any data*/
+u_int16_t ipv6_pseudohdr_chksum_split(u_char* buff, int hdrlen, const u_char* data, int datalen,
+		u_char* dest, u_char* src, int type){
 	struct ip6_pseudo_hdr hdr;
+	int len=hdrlen + datalen;
 
 	//create pseudo header
 	memset(&hdr, 0, sizeof(struct ip6_pseudo_hdr));
@@ -90,11 +102,16 @@ u_int16_t ipv6_pseudohdr_chksum(u_char* buff, int len, u_char* dest, u_char* src
 	hdr.len=htonl(len);
 
 	//calculate total checksum
-	return wrapsum(checksum((unsigned char*)&hdr,sizeof(struct ip6_pseudo_hdr),checksum(buff,len,0)));
+	return wrapsum(checksum((unsigned char*)&hdr,sizeof(struct ip6_pseudo_hdr),
+			checksum((u_char*)data,datalen,checksum(buff,hdrlen,0))));
 }
 
-u_int16_t ipv4_pseudohdr_chksum(u_char* buff, int len, u_char* dest, u_char* src, int type){
+/*Checksum a packet stored in two pieces: a header and data.
+ * hdrlen MUST be even if there is any data*/
+u_int16_t ipv4_pseudohdr_chksum_split(u_char* buff, int hdrlen, const u_char* data, int datalen,
+		u_char* dest, u_char* src, int type){
 	struct ip4_pseudo_hdr hdr;
+	int len=hdrlen + datalen;
 
 	//create pseudo header
 	memset(&hdr, 0, sizeof(struct ip4_pseudo_hdr));
@@ -104,7 +121,8 @@ u_int16_t ipv4_pseudohdr_chksum(u_char* buff, int len, u_char* dest, u_char* src
 	hdr.len=htonl(len);
 
 	//calculate total checksum
-	return wrapsum(checksum((u_char*)&hdr,sizeof(struct ip4_pseudo_hdr),checksum(buff,len,0)));
+	return wrapsum(checksum((u_char*)&hdr,sizeof(struct ip4_pseudo_hdr),
+			checksum((u_char*)data,datalen,checksum(buff,hdrlen,0))));
 }
 
 u_int16_t ipv4_chksum(u_char* buff, int len){
@@ -30,6 +30,10 @@ Date: 02/2013
 
 u_int16_t ipv6_pseudohdr_chksum(u_char* buff, int len, u_char* dest, u_char* src, int type);
 u_int16_t ipv4_pseudohdr_chksum(u_char* buff, int len, u_char* dest, u_char* src, int type);
+u_int16_t ipv6_pseudohdr_chksum_split(u_char* hdr, int hdrlen, const u_char* data, int datalen,
+		u_char* dest, u_char* src, int type);
+u_int16_t ipv4_pseudohdr_chksum_split(u_char* hdr, int hdrlen, const u_char* data, int datalen,
+		u_char* dest, u_char* src, int type);
 u_int16_t ipv4_chksum(u_char* buff, int len);
 
 
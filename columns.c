@@ -0,0 +1,263 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Functions for writing a columnar per-packet export of the
+		DCCP to TCP mapping.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	File format (all integers in host byte order):
+		Header:
+			char		magic[8];	"D2TCOLS\0"
+			u_int32_t	version;	1
+			u_int32_t	ncols;		Number of columns
+			u_int64_t	nrows;		Number of rows (packets)
+		ncols column descriptors:
+			char		name[16];	Column name, NUL padded
+			u_int32_t	width;		Bytes per value
+			u_int32_t	is_signed;	1 if values are signed integers
+			u_int64_t	offset;		File offset of the column (8 byte aligned)
+		Column data: nrows values of each column, one column after another.
+******************************************************************************/
+#include "dccp2tcp.h"
+
+#define COLS_MAGIC		"D2TCOLS"
+#define COLS_VERSION	1
+#define COLS_ALIGN		8
+
+/*Column descriptor as written to the file*/
+struct col_desc{
+	char				name[16];	/*Column name*/
+	u_int32_t			width;		/*Bytes per value*/
+	u_int32_t			is_signed;	/*Values are signed*/
+	u_int64_t			offset;		/*File offset of column data*/
+};
+
+/*File header*/
+struct col_hdr{
+	char				magic[8];	/*COLS_MAGIC*/
+	u_int32_t			version;	/*COLS_VERSION*/
+	u_int32_t			ncols;		/*Number of columns*/
+	u_int64_t			nrows;		/*Number of rows*/
+};
+
+/*Columns, in file order*/
+enum col_id{
+	COL_TIME,
+	COL_CONN,
+	COL_DIR,
+	COL_TYPE,
+	COL_DCCP_SEQ,
+	COL_DCCP_ACK,
+	COL_TCP_SEQ,
+	COL_TCP_ACK,
+	COL_LOSS,
+	COL_SIZE,
+	NUM_COLS,
+};
+
+static const struct col_desc col_defs[NUM_COLS]={
+	{"time_us",		8, 1, 0},	/*Capture time (microseconds since the epoch)*/
+	{"connection",	4, 0, 0},	/*Connection number, starting at 1*/
+	{"direction",	1, 0, 0},	/*0 from host A (initiator), 1 from host B*/
+	{"dccp_type",	1, 0, 0},	/*DCCP packet type*/
+	{"dccp_seq",	8, 0, 0},	/*48 bit DCCP sequence number*/
+	{"dccp_ack",	8, 0, 0},	/*48 bit DCCP ack number, 0 if none*/
+	{"tcp_seq",		4, 0, 0},	/*TCP sequence number*/
+	{"tcp_ack",		4, 0, 0},	/*TCP ack number*/
+	{"loss",		4, 0, 0},	/*Packets reported lost in the Ack Vector*/
+	{"size",		4, 0, 0},	/*DCCP payload size*/
+};
+
+/*Export state of a context*/
+struct col_state{
+	FILE			*out;				/*Export file*/
+	FILE			*tmp[NUM_COLS];		/*Temporary per-column data*/
+	u_int64_t		rows;				/*Rows written*/
+	int				failed;				/*A temporary file couldn't be written*/
+};
+
+void columns_write(enum col_id col, const void *val);
+void columns_abort();
+
+
+/*Open the columnar export file. Returns 0 (and turns the export off) if it
+ * can't be created*/
+int columns_open(const char *fname)
+{
+	d2t->cols=calloc(1, sizeof(struct col_state));
+	if(d2t->cols==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+	d2t->cols->out=fopen(fname,"wb");
+	if(d2t->cols->out==NULL){
+		dbgprintf(0,"Error opening columns file %s\n", fname);
+		columns_abort();
+		return 0;
+	}
+
+	/*Columns are collected in temporary files until we know the row count*/
+	for(int i=0; i < NUM_COLS; i++){
+		d2t->cols->tmp[i]=tmpfile();
+		if(d2t->cols->tmp[i]==NULL){
+			dbgprintf(0,"Error: Couldn't create temporary file\n");
+			columns_abort();
+			return 0;
+		}
+	}
+	d2t->cols->rows=0;
+return 1;
+}
+
+/*Add a row for a converted packet sent by h1*/
+void columns_packet(const struct packet *new, const struct const_packet *old, struct hcon *h1)
+{
+	struct tcphdr 				*tcph;
+	struct dccp_hdr 			*dccph;
+	struct dccp_hdr_ext 		*dccphex;
+	struct dccp_hdr_ack_bits 	*dccphack;
+	int64_t						time;
+	u_int64_t					seq;
+	u_int64_t					ack=0;
+	u_int32_t					val;
+	u_int8_t					byte;
+
+	/*cast header pointers*/
+	tcph=(struct tcphdr*)new->data;
+	dccph=(struct dccp_hdr*)old->data;
+	dccphex=(struct dccp_hdr_ext*)(old->data+sizeof(struct dccp_hdr));
+	dccphack=(struct dccp_hdr_ack_bits*)(old->data+ sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext));
+
+	time=(int64_t)old->h->ts.tv_sec*1000000 + old->h->ts.tv_usec;
+	columns_write(COL_TIME, &time);
+	val=h1->num/2 + 1;
+	columns_write(COL_CONN, &val);
+	byte=h1->num%2;
+	columns_write(COL_DIR, &byte);
+	byte=dccph->dccph_type;
+	columns_write(COL_TYPE, &byte);
+	seq=((u_int64_t)ntohs(dccph->dccph_seq)<<32) + ntohl(dccphex->dccph_seq_low);
+	columns_write(COL_DCCP_SEQ, &seq);
+	if(dccph->dccph_type!=DCCP_PKT_DATA && dccph->dccph_type!=DCCP_PKT_REQUEST){
+		ack=((u_int64_t)ntohs(dccphack->dccph_ack_nr_high)<<32) + ntohl(dccphack->dccph_ack_nr_low);
+	}
+	columns_write(COL_DCCP_ACK, &ack);
+	val=ntohl(tcph->seq);
+	columns_write(COL_TCP_SEQ, &val);
+	val=ntohl(tcph->ack_seq);
+	columns_write(COL_TCP_ACK, &val);
+	val=0;
+	if(ack!=0 && dccph->dccph_type!=DCCP_PKT_RESPONSE){
+		val=ack_vect_losses((u_char*)dccph, h1);
+	}
+	columns_write(COL_LOSS, &val);
+	val=0;
+	if(dccph->dccph_type==DCCP_PKT_DATA || dccph->dccph_type==DCCP_PKT_DATAACK){
+		val=old->length + old->tail_len - dccph->dccph_doff*4;
+	}
+	columns_write(COL_SIZE, &val);
+	d2t->cols->rows++;
+
+	if(d2t->cols->failed){
+		dbgprintf(0,"Error: Couldn't write temporary file\n");
+		columns_abort();
+	}
+}
+
+/*Write the header and column data, then close the export file*/
+void columns_finish()
+{
+	struct col_hdr		hdr;
+	struct col_desc		desc[NUM_COLS];
+	u_int64_t			offset;
+	char				buf[8192];
+	char				pad[COLS_ALIGN]={0};
+	size_t				len;
+	struct col_state	*c=d2t->cols;
+
+	if(c==NULL){
+		return;
+	}
+
+	/*Header*/
+	memset(&hdr,0,sizeof(struct col_hdr));
+	memcpy(hdr.magic, COLS_MAGIC, sizeof(COLS_MAGIC));
+	hdr.version=COLS_VERSION;
+	hdr.ncols=NUM_COLS;
+	hdr.nrows=c->rows;
+
+	/*Column descriptors*/
+	offset=sizeof(struct col_hdr) + sizeof(desc);
+	for(int i=0; i < NUM_COLS; i++){
+		desc[i]=col_defs[i];
+		desc[i].offset=offset;
+		offset+=(c->rows*desc[i].width + COLS_ALIGN - 1) & ~(u_int64_t)(COLS_ALIGN - 1);
+	}
+	fwrite(&hdr, sizeof(struct col_hdr), 1, c->out);
+	fwrite(desc, sizeof(desc), 1, c->out);
+
+	/*Column data*/
+	for(int i=0; i < NUM_COLS; i++){
+		rewind(c->tmp[i]);
+		while((len=fread(buf, 1, sizeof(buf), c->tmp[i])) > 0){
+			fwrite(buf, 1, len, c->out);
+		}
+		fclose(c->tmp[i]);
+		len=(c->rows*desc[i].width) % COLS_ALIGN;
+		if(len){
+			fwrite(pad, 1, COLS_ALIGN - len, c->out);
+		}
+	}
+
+	if(fclose(c->out)!=0){
+		dbgprintf(0,"Error writing columns file\n");
+		d2t->error=1;
+	}
+	free(c);
+	d2t->cols=NULL;
+}
+
+/*Append one value to a column*/
+void columns_write(enum col_id col, const void *val)
+{
+	if(fwrite(val, col_defs[col].width, 1, d2t->cols->tmp[col])!=1){
+		d2t->cols->failed=1;
+	}
+}
+
+/*Give up on the export: close and free everything, leave the file as it is
+ * and don't export any more packets*/
+void columns_abort()
+{
+	struct col_state	*c=d2t->cols;
+
+	for(int i=0; i < NUM_COLS; i++){
+		if(c->tmp[i]){
+			fclose(c->tmp[i]);
+		}
+	}
+	if(c->out){
+		fclose(c->out);
+	}
+	free(c);
+	d2t->cols=NULL;
+	d2t->columns=NULL;
+	d2t->error=1;
+}
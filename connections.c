@@ -21,40 +21,48 @@ Author: Samuel Jero <sj323707@ohio.edu>
 Date: 02/2013
 ******************************************************************************/
 #include "dccp2tcp.h"
-
-int isClosed(struct hcon *A, struct hcon *B, enum dccp_pkt_type pkt_type);
+#include "encap.h"
+
+int isClosed(struct connection *con, enum dccp_pkt_type pkt_type);
+static inline __attribute__((always_inline)) int match_conn(struct connection *ptr, u_char *src_id, u_char* dest_id, int id_len,
+		int src_port, int dest_port, enum dccp_pkt_type pkt_type, struct hcon **fwd, struct hcon **rev);
+struct connection *alloc_connection();
+struct tbl *alloc_table();
+void free_table(struct hcon *hcn);
+void shrink_table(struct hcon *hcn);
+int tail_slot(struct hcon *hcn, int i, int n);
+
+/*Connections are carved out of slabs of CONN_SLAB and live until cleanup*/
+struct conn_slab{
+	struct conn_slab	*next;				/*List pointer*/
+	int					used;				/*Connections handed out*/
+	struct connection	conns[CONN_SLAB];	/*Connections*/
+};
+
+/*Sequence number tables of retired connections, waiting for reuse*/
+struct tbl_free{
+	struct tbl_free		*next;	/*List pointer*/
+};
 
 /*Lookup a connection. If it doesn't exist, add a new connection and return it.*/
 int get_host(u_char *src_id, u_char* dest_id, int id_len, int src_port, int dest_port,
 		enum dccp_pkt_type pkt_type, struct hcon **fwd, struct hcon **rev){
 	struct connection *ptr;
 
-	/*Empty list*/
-	if(chead==NULL){
-		if(add_connection(src_id, dest_id, id_len, src_port, dest_port)==NULL){
-			return 1;
-		}
-		*fwd=&chead->A;
-		*rev=&chead->B;
+	/*Packets tend to come in runs of the same connection, so try the
+	 * connection of the last packet first. There is at most one open
+	 * connection per four-tuple, so this finds the same one as the list*/
+	ptr=d2t->last_conn;
+	if(ptr!=NULL && match_conn(ptr, src_id, dest_id, id_len, src_port, dest_port, pkt_type, fwd, rev)){
 		return 0;
 	}
 
 	/*Loop list looking for connection*/
-	ptr=chead;
-	while(ptr!=NULL){
-		if(memcmp(ptr->A.id,src_id,id_len)==0 && ptr->A.port==src_port &&
-				!isClosed(&ptr->A, &ptr->B, pkt_type)){
-			*fwd=&ptr->A;
-			*rev=&ptr->B;
-			return 0;
-		}
-		if(memcmp(ptr->B.id,src_id,id_len)==0 && ptr->B.port==src_port &&
-				!isClosed(&ptr->A, &ptr->B, pkt_type)){
-			*fwd=&ptr->B;
-			*rev=&ptr->A;
+	for(ptr=d2t->chead; ptr!=NULL; ptr=ptr->next){
+		if(match_conn(ptr, src_id, dest_id, id_len, src_port, dest_port, pkt_type, fwd, rev)){
+			d2t->last_conn=ptr;
 			return 0;
 		}
-		ptr=ptr->next;
 	}
 
 	/*Add new connection*/
@@ -64,24 +72,49 @@ int get_host(u_char *src_id, u_char* dest_id, int id_len, int src_port, int dest
 	}
 	*fwd=&ptr->A;
 	*rev=&ptr->B;
+	d2t->last_conn=ptr;
 	return 0;
 }
 
+/*Returns true if con is the open connection of this four-tuple, setting the
+ * half-connections in each direction*/
+static inline __attribute__((always_inline)) int match_conn(struct connection *ptr, u_char *src_id, u_char* dest_id, int id_len,
+		int src_port, int dest_port, enum dccp_pkt_type pkt_type, struct hcon **fwd, struct hcon **rev){
+	if(ptr->A.port==src_port && ptr->B.port==dest_port &&
+			memcmp(ptr->A.id,src_id,id_len)==0 && memcmp(ptr->B.id,dest_id,id_len)==0 &&
+			!isClosed(ptr, pkt_type)){
+		*fwd=&ptr->A;
+		*rev=&ptr->B;
+		return TRUE;
+	}
+	if(ptr->B.port==src_port && ptr->A.port==dest_port &&
+			memcmp(ptr->B.id,src_id,id_len)==0 && memcmp(ptr->A.id,dest_id,id_len)==0 &&
+			!isClosed(ptr, pkt_type)){
+		*fwd=&ptr->B;
+		*rev=&ptr->A;
+		return TRUE;
+	}
+	return FALSE;
+}
+
 /*Returns true if the connection is closed and any packets should go to
  * a new connection with the same four-tuple*/
-int isClosed(struct hcon *A, struct hcon *B, enum dccp_pkt_type pkt_type){
+int isClosed(struct connection *con, enum dccp_pkt_type pkt_type){
+	struct hcon *A=&con->A;
+	struct hcon *B=&con->B;
+
 	if(pkt_type==DCCP_PKT_REQUEST || pkt_type==DCCP_PKT_RESPONSE){
 		if(A->state==CLOSE && B->state==CLOSE){
 			/*We're opening a new connection on hosts/ports we've used before, mark
 			 * old connection as dead*/
 			A->state=DEAD;
 			B->state=DEAD;
+			retire_connection(con);
 			return TRUE;
 		}
-	}else{
-		if(A->state==DEAD || B->state==DEAD){
-			return TRUE;
-		}
+	}
+	if(A->state==DEAD || B->state==DEAD){
+		return TRUE;
 	}
 	return FALSE;
 }
@@ -89,45 +122,203 @@ int isClosed(struct hcon *A, struct hcon *B, enum dccp_pkt_type pkt_type){
 /*Add a connection. Return it. On failure, return NULL*/
 struct connection *add_connection(u_char *src_id, u_char* dest_id, int id_len, int src_port, int dest_port){
 	struct connection *ptr;
-	struct connection *prev;
 
-	/*Allocate memory*/
-	if(chead==NULL){
-		ptr=chead=malloc(sizeof(struct connection));
-	}else{
-		ptr=chead;
-		prev=chead;
-		while(ptr!=NULL){
-			prev=ptr;
-			ptr=ptr->next;
-		}
-		ptr=prev->next=malloc(sizeof(struct connection));
+	if(id_len > IP6_ADDR_LEN){
+		dbgprintf(0,"Error: Host ID too long\n");
+		return NULL;
 	}
 
-	if(ptr==NULL){
-		dbgprintf(0,"Error: Couldn't allocate Memory\n");
-		exit(1);
+	/*Allocate memory and append to list*/
+	ptr=alloc_connection();
+	if(d2t->chead==NULL){
+		d2t->chead=ptr;
+	}else{
+		d2t->ctail->next=ptr;
 	}
+	d2t->ctail=ptr;
 
 	/*Initialize*/
-	ptr->A.id=malloc(id_len);
-	ptr->B.id=malloc(id_len);
-	if(ptr->A.id==NULL||ptr->B.id==NULL){
-		dbgprintf(0,"Error: Couldn't allocate Memory\n");
-		exit(1);
-	}
+	memset(ptr,0,sizeof(struct connection));
+	ptr->next=NULL;
 	memcpy(ptr->A.id,src_id,id_len);
+	ptr->A.id_len=id_len;
+	ptr->A.num=d2t->num_hcons++;
 	ptr->A.port=src_port;
 	ptr->A.state=INIT;
 	ptr->A.type=UNKNOWN;
+	ptr->A.table=NULL;
+	ptr->A.xpl=NULL;
 	memcpy(ptr->B.id,dest_id,id_len);
+	ptr->B.id_len=id_len;
+	ptr->B.num=d2t->num_hcons++;
 	ptr->B.port=dest_port;
 	ptr->B.state=INIT;
 	ptr->B.type=UNKNOWN;
+	ptr->B.table=NULL;
+	ptr->B.xpl=NULL;
 
+	/*Connections not selected are ignored from the start*/
+	if(d2t->filter){
+		filter_connection(ptr);
+	}
 	return ptr;
 }
 
+/*Get an unused connection from the current slab, starting a new slab if needed*/
+struct connection *alloc_connection()
+{
+	struct conn_slab *slab;
+
+	if(d2t->slabs==NULL || d2t->slabs->used==CONN_SLAB){
+		slab=malloc(sizeof(struct conn_slab));
+		if(slab==NULL){
+			dbgprintf(0,"Error: Couldn't allocate Memory\n");
+			exit(1);
+		}
+		slab->used=0;
+		slab->next=d2t->slabs;
+		d2t->slabs=slab;
+		d2t->alloc.slabs++;
+	}
+	d2t->alloc.conns++;
+return &d2t->slabs->conns[d2t->slabs->used++];
+}
+
+/*Get a Sequence Number Table, reusing one from a retired connection if
+ * possible. A reused table isn't cleared: only the first hcn->used entries
+ * are ever read*/
+struct tbl *alloc_table()
+{
+	struct tbl *table;
+
+	if(d2t->tbl_free!=NULL){
+		table=(struct tbl*)d2t->tbl_free;
+		d2t->tbl_free=d2t->tbl_free->next;
+		d2t->alloc.tbl_reuse++;
+	}else{
+		table=(struct tbl*)calloc(TBL_SZ, sizeof(struct tbl));
+		if(table==NULL){
+			dbgprintf(0,"Can't Allocate Memory!\n");
+			exit(1);
+		}
+		d2t->alloc.tbl_alloc++;
+	}
+
+	d2t->alloc.tbl_used++;
+	if(d2t->alloc.tbl_used > d2t->alloc.tbl_peak){
+		d2t->alloc.tbl_peak=d2t->alloc.tbl_used;
+	}
+return table;
+}
+
+/*Put the Sequence Number Table of hcn on the free list (a table shrunk by
+ * close_connection() is just freed)*/
+void free_table(struct hcon *hcn)
+{
+	struct tbl_free *f;
+
+	if(hcn->table==NULL){
+		return;
+	}
+	if(hcn->size==TBL_SZ){
+		f=(struct tbl_free*)hcn->table;
+		f->next=d2t->tbl_free;
+		d2t->tbl_free=f;
+		d2t->alloc.tbl_used--;
+		d2t->alloc.tbl_retired++;
+	}else{
+		free(hcn->table);
+	}
+	hcn->table=NULL;
+}
+
+/*A dead connection never sees another packet, so give its tables to
+ * new connections. Statistics counters and graphs are kept.*/
+void retire_connection(struct connection *con)
+{
+	free_table(&con->A);
+	free_table(&con->B);
+	free(con->A.stats.sent);
+	free(con->B.stats.sent);
+	con->A.stats.sent=NULL;
+	con->B.stats.sent=NULL;
+}
+
+/*Both hosts have closed the connection. Its tables go to new connections,
+ * keeping only the newest TBL_TAIL entries for the last few packets (a
+ * retransmitted Close or Reset, Acks of the Reset)*/
+void close_connection(struct connection *con)
+{
+	shrink_table(&con->A);
+	shrink_table(&con->B);
+}
+
+/*Replace the table of hcn with one holding its newest TBL_TAIL entries,
+ * oldest first, along with their send times*/
+void shrink_table(struct hcon *hcn)
+{
+	struct tbl		*tail;
+	struct timeval	*sent;
+	int				n;
+
+	if(hcn->table==NULL || hcn->size!=TBL_SZ){
+		return;
+	}
+	n= hcn->used < TBL_TAIL ? hcn->used : TBL_TAIL;
+	tail=malloc(TBL_TAIL*sizeof(struct tbl));
+	if(tail==NULL){
+		dbgprintf(0,"Can't Allocate Memory!\n");
+		exit(1);
+	}
+	for(int i=0; i < n; i++){
+		tail[i]=hcn->table[(hcn->cur - n + 1 + i + hcn->size)%hcn->size];
+	}
+
+	if(hcn->stats.sent!=NULL){
+		sent=calloc(TBL_TAIL, sizeof(struct timeval));
+		if(sent==NULL){
+			dbgprintf(0,"Can't Allocate Memory!\n");
+			exit(1);
+		}
+		for(int i=0; i < n; i++){
+			sent[i]=hcn->stats.sent[(hcn->cur - n + 1 + i + hcn->size)%hcn->size];
+		}
+		free(hcn->stats.sent);
+		hcn->stats.sent=sent;
+		hcn->stats.last_slot=tail_slot(hcn, hcn->stats.last_slot, n);
+	}
+
+	hcn->last=tail_slot(hcn, hcn->last, n);
+	free_table(hcn);
+	hcn->table=tail;
+	hcn->size=TBL_TAIL;
+	hcn->used=n;
+	hcn->cur=n - 1;
+}
+
+/*Index in the shrunk table of entry i of the full one (the newest entry if
+ * it wasn't kept)*/
+int tail_slot(struct hcon *hcn, int i, int n)
+{
+	int dist;
+
+	dist=(hcn->cur - i + hcn->size)%hcn->size;
+	if(dist >= n){
+		return n - 1;
+	}
+return n - 1 - dist;
+}
+
+/*Print allocation statistics (with -v)*/
+void print_alloc_stats()
+{
+	dbgprintf(1,"Connections: %i in %i slabs of %i (%lu bytes each)\n",
+			d2t->alloc.conns, d2t->alloc.slabs, CONN_SLAB, (unsigned long)sizeof(struct conn_slab));
+	dbgprintf(1,"Sequence Number Tables: %i allocated, %i reused, %i retired, %i peak in use (%lu bytes each)\n",
+			d2t->alloc.tbl_alloc, d2t->alloc.tbl_reuse, d2t->alloc.tbl_retired,
+			d2t->alloc.tbl_peak, (unsigned long)(sizeof(struct tbl)*TBL_SZ));
+}
+
 /*Update the state on a host*/
 int update_state(struct hcon* hst, enum con_state st){
 	if(!hst){
@@ -137,18 +328,54 @@ int update_state(struct hcon* hst, enum con_state st){
 	return 0;
 }
 
+/*Print the address of a half-connection*/
+char* print_host(char* buf, int len, struct hcon *hcn)
+{
+	buf[0]=0;
+	if(hcn->id_len==IP4_ADDR_LEN){
+		print_ipv4(buf,len,hcn->id,hcn->id_len);
+	}else if(hcn->id_len==IP6_ADDR_LEN){
+		print_ipv6(buf,len,hcn->id,hcn->id_len);
+	}
+	return buf;
+}
+
+/*Printable address of a half-connection. It is formatted (getnameinfo())
+ * once and cached for all later diagnostics*/
+const char* host_name(struct hcon *hcn)
+{
+	if(hcn->name[0]==0){
+		print_host(hcn->name, INET6_ADDRSTRLEN, hcn);
+		if(hcn->name[0]==0){
+			strcpy(hcn->name, "?");
+		}
+	}
+	return hcn->name;
+}
+
 /*Free all connections*/
 void cleanup_connections(){
 	struct connection *ptr;
-	struct connection *prev;
-	prev=ptr=chead;
+	struct conn_slab *slab;
+	struct tbl_free *f;
+
+	for(ptr=d2t->chead; ptr!=NULL; ptr=ptr->next){
+		free(ptr->A.table);
+		free(ptr->B.table);
+		stats_free(&ptr->A);
+		stats_free(&ptr->B);
+	}
+	d2t->chead=d2t->ctail=d2t->last_conn=NULL;
 
-	while(ptr!=NULL){
-		prev=ptr;
-		free(ptr->A.id);
-		free(ptr->B.id);
-		ptr=ptr->next;
-		free(prev);
+	while(d2t->slabs!=NULL){
+		slab=d2t->slabs;
+		d2t->slabs=d2t->slabs->next;
+		free(slab);
+	}
+	while(d2t->tbl_free!=NULL){
+		f=d2t->tbl_free;
+		d2t->tbl_free=d2t->tbl_free->next;
+		free(f);
 	}
 return;
 }
@@ -158,15 +385,13 @@ u_int32_t initialize_hcon(struct hcon *hcn, d_seq_num initial)
 {
 	/*set default values*/
 	hcn->cur=0;
+	hcn->last=0;
 	hcn->size=TBL_SZ;
+	hcn->used=1;
 	hcn->high_ack=0;
 
 	/*allocate table*/
-	hcn->table=(struct tbl*)malloc(sizeof(struct tbl)*TBL_SZ);
-	if(hcn->table==NULL){
-		dbgprintf(0,"Can't Allocate Memory!\n");
-		exit(1);
-	}
+	hcn->table=alloc_table();
 
 	/*add first sequence number*/
 	hcn->table[0].old=initial;
@@ -187,20 +412,23 @@ u_int32_t add_new_seq(struct hcon *hcn, d_seq_num num, int size, enum dccp_pkt_t
 	}
 
 	if(hcn->table==NULL){
-		dbgprintf(1, "Warning: Connection uninitialized\n");
+		warnprintf(hcn, WARN_UNINIT, "Warning: Connection uninitialized\n");
 		return initialize_hcon(hcn, num);
 	}
 
 	/*account for missing packets*/
 	if(num - hcn->table[hcn->cur].old +1 >=100){
-			dbgprintf(1,"Missing more than 100 packets!\n");
+			warnprintf(hcn, WARN_MISSING_MANY, "Missing more than 100 packets!\n");
 	}
 	while(hcn->table[hcn->cur].old +1 < num && hcn->table[hcn->cur].old +1 > 0){
 		prev=hcn->cur;
 		if(num - hcn->table[hcn->cur].old +1 <100){
-			dbgprintf(1,"Missing Packet %i\n",hcn->table[prev].new+1);
+			warnprintf(hcn, WARN_MISSING, "Missing Packet %i\n",hcn->table[prev].new+1);
 		}
 		hcn->cur=(hcn->cur+1)%(hcn->size);/*find next available table slot*/
+		if(hcn->used < hcn->size){
+			hcn->used++;
+		}
 		hcn->table[hcn->cur].old=hcn->table[prev].old+1;
 		hcn->table[hcn->cur].new=hcn->table[prev].new + hcn->table[prev].size;
 		hcn->table[hcn->cur].size=size;
@@ -209,6 +437,9 @@ u_int32_t add_new_seq(struct hcon *hcn, d_seq_num num, int size, enum dccp_pkt_t
 
 	prev=hcn->cur;
 	hcn->cur=(hcn->cur+1)%(hcn->size);/*find next available table slot*/
+	if(hcn->used < hcn->size){
+		hcn->used++;
+	}
 	hcn->table[hcn->cur].old=num;
 	hcn->table[hcn->cur].size=size;
 	hcn->table[hcn->cur].type=type;
@@ -229,27 +460,69 @@ u_int32_t add_new_seq(struct hcon *hcn, d_seq_num num, int size, enum dccp_pkt_t
 return hcn->table[hcn->cur].new +1;
 }
 
+/*Find the table entry for a DCCP sequence number. Returns -1 if not found.
+ * Until the table wraps, only entries 0 to cur are valid (hcn->used)*/
+int lookup_seq(struct hcon *hcn, d_seq_num num)
+{
+	int dist;
+	int i;
+
+	/*add_new_seq() fills gaps, so entries are usually consecutive up to cur*/
+	dist=hcn->table[hcn->cur].old - num;
+	if(dist >= 0 && dist < hcn->used){
+		i=(hcn->cur - dist + hcn->size)%hcn->size;
+		if(hcn->table[i].old==num){
+			hcn->last=i;
+			return i;
+		}
+	}
+
+	/*ACKs mostly advance, so search outward from the last hit*/
+	for(int d=0; d < LOOKUP_WIN; d++){
+		i=(hcn->last + d)%hcn->size;
+		if(i < hcn->used && hcn->table[i].old==num){
+			hcn->last=i;
+			return i;
+		}
+		i=(hcn->last - d - 1 + hcn->size)%hcn->size;
+		if(i < hcn->used && hcn->table[i].old==num){
+			hcn->last=i;
+			return i;
+		}
+	}
+
+	/*loop through table looking for the DCCP sequence number*/
+	for(i=0; i < hcn->used; i++){
+		if(hcn->table[i].old==num){
+			hcn->last=i;
+			return i;
+		}
+	}
+return -1;
+}
+
 /*Convert Ack Numbers*/
 u_int32_t convert_ack(struct hcon *hcn, d_seq_num num, struct hcon *o_hcn)
 {
+	int i;
+
 	if(hcn==NULL){
 		dbgprintf(0,"ERROR NULL POINTER!\n");
 		exit(1);
 	}
 
 	if(hcn->table==NULL){
-		dbgprintf(1, "Warning: Connection uninitialized\n");
+		warnprintf(hcn, WARN_UNINIT, "Warning: Connection uninitialized\n");
 		initialize_hcon(hcn, num);
 	}
 
-	/*loop through table looking for the DCCP ack number*/
-	for(int i=0; i < hcn->size; i++){
-		if(hcn->table[i].old==num){
-			return 	hcn->table[i].new + hcn->table[i].size + 1; /*TCP acks the sequence number plus 1*/
-		}
+	/*find the DCCP ack number*/
+	i=lookup_seq(hcn,num);
+	if(i>=0){
+		return 	hcn->table[i].new + hcn->table[i].size + 1; /*TCP acks the sequence number plus 1*/
 	}
 
-	dbgprintf(1, "Error: Sequence Number Not Found! looking for %i. Using highest ACK, %i, instead.\n",
+	warnprintf(hcn, WARN_SEQ_NOT_FOUND, "Error: Sequence Number Not Found! looking for %i. Using highest ACK, %i, instead.\n",
 																						num, o_hcn->high_ack);
 return o_hcn->high_ack;
 }
@@ -257,98 +530,24 @@ return o_hcn->high_ack;
 /* Get size of packet being acked*/
 int acked_packet_size(struct hcon *hcn, d_seq_num num)
 {
+	int i;
+
 	if(hcn==NULL){
 		dbgprintf(0,"ERROR NULL POINTER!\n");
 		exit(1);
 	}
 
 	if(hcn->table==NULL){
-		dbgprintf(1, "Warning: Connection uninitialized\n");
+		warnprintf(hcn, WARN_UNINIT, "Warning: Connection uninitialized\n");
 		initialize_hcon(hcn, num);
 	}
 
-	/*loop through table looking for the DCCP ack number*/
-	for(int i=0; i < hcn->size; i++){
-		if(hcn->table[i].old==num){
-			return 	hcn->table[i].size;
-		}
+	/*find the DCCP ack number*/
+	i=lookup_seq(hcn,num);
+	if(i>=0){
+		return 	hcn->table[i].size;
 	}
 
-	dbgprintf(1, "Error: Sequence Number Not Found! looking for %i\n", num);
+	warnprintf(hcn, WARN_SEQ_NOT_FOUND, "Error: Sequence Number Not Found! looking for %i\n", num);
 return 0;
 }
-
-/*Parse Ack Vector Options
- * Returns the Number of packets since last recorded loss*/
-unsigned int interp_ack_vect(u_char* hdr)
-{
-	int hdrlen=((struct dccp_hdr*)hdr)->dccph_doff*4;
-	//struct dccp_hdr_ext* e=(struct dccp_hdr_ext*)hdr + sizeof(struct dccp_hdr);
-	int optlen;
-	int len;
-	int tmp;
-	int bp=0;
-	int additional=0;
-	u_char* opt;
-	u_char* cur;
-
-	/*setup pointer to DCCP options and determine how long the options are*/
-	optlen=hdrlen-sizeof(struct dccp_hdr) - sizeof(struct dccp_hdr_ext) - sizeof(struct dccp_hdr_ack_bits);
-	opt=hdr + sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext) + sizeof(struct dccp_hdr_ack_bits);
-
-	if(optlen<=0){
-		return 0;
-	}
-
-	/*parse options*/
-	while(optlen > 0){
-
-		/*One byte options (no length)*/
-		if(*opt< 32){
-			optlen--;
-			opt++;
-			continue;
-		}
-
-		/*Check option length*/
-		len=*(opt+1);
-		if(len > optlen){
-			dbgprintf(0, "Warning: Option would extend into packet data\n");
-			return additional;
-		}
-
-		/*Ack Vector Option*/
-		if(*opt==38 || *opt==39){
-			tmp=len-2;
-			cur=opt+2;
-			/*loop through Vector*/
-			while(tmp > 0){
-				/*ack vector works BACKWARDS through time*/
-
-				/*keep track of total packets recieved and if
-				a packet is lost, subtract all packets received
-				after that*/
-				if((*cur & 0xC0)==0xC0 || (*cur & 0xC0)==0x40){ //lost packet
-					bp+=(*cur & 0x3F)+1;
-					additional= -bp;
-				}
-
-				if((*cur & 0xC0)==0x00){ //received packet
-					bp+= (*cur & 0x3F)+1;
-				}
-
-				if(((*cur& 0xC0)!= 0xC0) && ((*cur& 0xC0)!= 0x00) && ((*cur& 0xC0)!= 0x40)){
-					dbgprintf(1, "Warning: Invalid Ack Vector!! (Linux will handle poorly!)\n");
-				}
-				tmp--;
-				cur++;
-			}
-		}
-
-		optlen-=len;
-		opt+=len;
-	}
-
-	dbgprintf(2,"Ack vector adding: %i\n", additional);
-return additional;
-}
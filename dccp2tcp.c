@@ -23,26 +23,17 @@ Date: 02/2013
 Notes:
 	1)DCCP MUST use 48 bit sequence numbers
 	2)DCCP Ack packets show up as TCP packets containing one byte
+	3)Apart from constant tables there is no global state. Options and
+		connections belong to the current context, d2t, set by ctx_*()
 ******************************************************************************/
 #include "dccp2tcp.h"
 
 
-#define DCCP2TCP_VERSION 1.6
-#define COPYRIGHT_YEAR 2013
+static struct d2t_ctx	d2t_default;		/*context outside any conversion*/
+__thread struct d2t_ctx	*d2t=&d2t_default;	/*current context of this thread*/
 
 
-int debug=0;	/*set to 1 to turn on debugging information*/
-int yellow=0;	/*tcptrace yellow line as currently acked packet*/
-int green=0;	/*tcptrace green line as currently acked packet*/
-int sack=0;		/*add TCP SACKS*/
-
-
-pcap_t*			in;			/*libpcap input file discriptor*/
-pcap_dumper_t	*out;		/*libpcap output file discriptor*/
-struct connection *chead;	/*connection list*/
-
-
-void handle_packet(u_char *user, const struct pcap_pkthdr *h, const u_char *bytes);
+int convert_one(int slot, const struct pcap_pkthdr *h, const u_char *bytes, struct d2t_pkt *out);
 int handle_request(struct packet* new, const struct const_packet* old, struct hcon* h1, struct hcon* h2);
 int handle_response(struct packet* new, const struct const_packet* old, struct hcon* h1, struct hcon* h2);
 int handle_dataack(struct packet* new, const struct const_packet* old, struct hcon* h1, struct hcon* h2);
@@ -55,159 +46,260 @@ int handle_syncack(struct packet* new, const struct const_packet* old, struct hc
 int handle_data(struct packet* new, const struct const_packet* old, struct hcon* h1, struct hcon* h2);
 int parse_options(const u_char* opt_start, int len,
 			const struct const_packet* pkt, struct hcon* A, struct hcon* B);
+int parse_option_list(const u_char* opt_start, int len,
+			const struct const_packet* pkt, struct hcon* A, struct hcon* B);
 int process_feature(const u_char* feat, int len, int confirm, int L,
 			const struct const_packet* pkt, struct hcon* A, struct hcon* B);
-void ack_vect2sack(struct hcon *seq, struct tcphdr *tcph,
-			u_char* tcpopts, u_char* dccphdr, d_seq_num dccpack, struct hcon* o_hcn);
-void version();
-void usage();
 
 
-/*Parse commandline options and open files*/
-int main(int argc, char *argv[])
+
+
+/*Create a conversion context. Options and the link type are zero, set them
+ * before the first packet. The new context is made the current one*/
+struct d2t_ctx *ctx_new()
 {
-	char ebuf[200];
-	char *erbuffer=ebuf;
-	char *dfile=NULL;
-	char *tfile=NULL;
-
-	/*parse commandline options*/
-	if(argc > 9){
-		usage();
-	}
-
-	/*loop through commandline options*/
-	for(int i=1; i < argc; i++){
-		if(argv[i][0]!='-' || (argv[i][0]=='-' && strlen(argv[i])==1)){
-			if(dfile==NULL  || argv[i][0]=='-'){
-				/*assign first non-dash (or only dash) argument to the dccp file*/
-				dfile=argv[i];
-			}else{
-				if(tfile==NULL){
-					tfile=argv[i]; /*assign second non-dash argument to the dccp file*/
-				}else{
-					usage();
-				}
-			}
-		}else{
-			if(argv[i][1]=='v' && strlen(argv[i])==2){ /* -v */
-				debug++;
-			}else if(argv[i][1]=='y' && strlen(argv[i])==2){ /* -y */
-				yellow=1;
-			}else if(argv[i][1]=='g' && strlen(argv[i])==2){ /* -g */
-				green=1;
-			}else if(argv[i][1]=='s' && strlen(argv[i])==2){ /* -s */
-				sack++;
-			}else if(argv[i][1]=='h' && strlen(argv[i])==2){ /* -h */
-				usage();
-			}else if(argv[i][1]=='V' && strlen(argv[i])==2){ /* -V */
-				version();
-			}else{
-				usage();
-			}
-		}
-	}
-	
-	if(dfile==NULL || tfile==NULL){
-		usage();
+	struct d2t_ctx *ctx;
+
+	ctx=calloc(1, sizeof(struct d2t_ctx));
+	if(ctx==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
 	}
+	ctx->prof.cur=PROF_READ;
+	d2t=ctx;
+return ctx;
+}
 
-	/*all options validated*/
+/*Free a context with its connections and buffers. Output files are the
+ * caller's (ctx_finish() closes the graphs and the columns file)*/
+void ctx_free(struct d2t_ctx *ctx)
+{
+	d2t=ctx;
+	cleanup_connections();
+	for(int i=0; i < ctx->nbufs; i++){
+		free(ctx->bufs[i]);
+	}
+	free(ctx->bufs);
+	free(ctx->buf_lens);
+	free(ctx->keep);
+	free(ctx);
+	d2t=&d2t_default;
+}
 
-	if(debug){
-		if(green){
-			dbgprintf(1,"Tcptrace green line at highest acknowledgment\n");
-		}else{
-			dbgprintf(1,"Tcptrace green line at highest acknowledged acknowledgment\n");
-		}
-		if(yellow){
-			dbgprintf(1,"Tcptrace yellow line at highest acknowledgment\n");
-		}else{
-			dbgprintf(1,"Tcptrace yellow line window value (a made up number)\n");
-		}
-		if(sack){
-			dbgprintf(1,"Adding TCP SACKS\n");
-		}
-		dbgprintf(1,"Input file: %s\n", dfile);
-		dbgprintf(1,"Output file: %s\n", tfile);
+/*Write out the buffered part of the TCP capture and the time sequence graphs,
+ * for readers following them while we convert*/
+void ctx_flush(struct d2t_ctx *ctx)
+{
+	d2t=ctx;
+	ctx->unflushed=0;
+	if(ctx->out){
+		pcap_dump_flush(ctx->out);
+	}
+	if(ctx->xplot){
+		xplot_flush();
 	}
+}
 
-	/*attempt to open input file*/
-	in=pcap_open_offline(dfile, erbuffer);
-	if(in==NULL){
-		dbgprintf(0,"Error opening input file\n");
-		exit(1);
+/*Finish the outputs written while converting (time sequence graphs and the
+ * columns file). Statistics are still available until ctx_free().
+ * Returns 0 if an output couldn't be written (then it was abandoned when
+ * the error occurred and conversion went on without it)*/
+int ctx_finish(struct d2t_ctx *ctx)
+{
+	d2t=ctx;
+	if(ctx->xplot){
+		xplot_finish();
+	}
+	if(ctx->columns){
+		columns_finish();
 	}
+return !ctx->error;
+}
 
-	/*attempt to open output file*/
-	out=pcap_dump_open(in,tfile);
-	if(out==NULL){
-		dbgprintf(0,"Error opening output file\n");
-		exit(1);
+/*Convert one packet. Returns 1 and fills out if a TCP packet was produced,
+ * 0 if the packet was dropped. out is valid until the next conversion*/
+int ctx_convert(struct d2t_ctx *ctx, const struct pcap_pkthdr *h, const u_char *bytes,
+		struct d2t_pkt *out)
+{
+	enum prof_stage		prof;
+	int					ret;
+
+	d2t=ctx;
+	prof=PROF_ENTER(PROF_ENCAP);
+	ret=convert_one(0, h, bytes, out);
+	PROF_LEAVE(prof);
+return ret;
+}
+
+/*Convert n packets. The TCP packets produced are stored at the start of out,
+ * in order, and their number is returned. Each uses its own buffer, so all
+ * of them are valid until the next conversion. The headers of the next
+ * packet are prefetched while one is converted, and runs of packets of the
+ * same connection are found without searching (see get_host())*/
+int ctx_convert_batch(struct d2t_ctx *ctx, int n, const struct pcap_pkthdr **h,
+		const u_char **bytes, struct d2t_pkt *out)
+{
+	enum prof_stage		prof;
+	int					cnt=0;
+
+	d2t=ctx;
+	if(n <= 0){
+		return 0;
 	}
 
-	/*process packets*/
-	chead=NULL;
-	u_char *user=(u_char*)out;
-	pcap_loop(in, -1, handle_packet, user);	
-	
-	/*close files*/
-	pcap_close(in);
-	pcap_dump_close(out);
+	/*Set up the buffers for the whole batch at once*/
+	packet_buffer(n - 1, MAX_PACKET);
 
-	/*Delete all connections*/
-	cleanup_connections();
-return 0;
+	for(int i=0; i < n; i++){
+		if(i + 1 < n){
+			__builtin_prefetch(h[i + 1]);
+			__builtin_prefetch(bytes[i + 1]);
+			__builtin_prefetch(bytes[i + 1] + 64);
+		}
+		prof=PROF_ENTER(PROF_ENCAP);
+		cnt+=convert_one(cnt, h[i], bytes[i], &out[cnt]);
+		PROF_LEAVE(prof);
+	}
+return cnt;
 }
 
-
-/*call back function for pcap_loop--do basic packet handling*/
+/*call back function for pcap_loop--convert a packet of the context in user
+ * and write it to the context's output capture, flushing it as often as
+ * flush_packets and flush_ms ask for*/
 void handle_packet(u_char *user, const struct pcap_pkthdr *h, const u_char *bytes)
 {
-	u_char 				*ndata;
-	struct pcap_pkthdr 	nh;
-	int					link_type;
+	struct d2t_ctx		*ctx=(struct d2t_ctx*)user;
+	struct d2t_pkt		pkt;
+	enum prof_stage		prof;
+	int64_t				ms;
+
+	if(!ctx_convert(ctx, h, bytes, &pkt) || !ctx->out){
+		return;
+	}
+
+	/*save packet*/
+	prof=PROF_ENTER(PROF_DUMP);
+	dump_packet(ctx->out, &pkt);
+	if(ctx->flush_packets || ctx->flush_ms){
+		ctx->unflushed++;
+		if(!timerisset(&ctx->flushed)){
+			ctx->flushed=pkt.h.ts;
+		}
+		ms=(int64_t)(pkt.h.ts.tv_sec - ctx->flushed.tv_sec)*1000 +
+				(pkt.h.ts.tv_usec - ctx->flushed.tv_usec)/1000;
+		if((ctx->flush_packets && ctx->unflushed >= ctx->flush_packets) ||
+				(ctx->flush_ms && ms >= ctx->flush_ms)){
+			ctx_flush(ctx);
+			ctx->flushed=pkt.h.ts;
+		}
+	}
+	PROF_LEAVE(prof);
+return;
+}
+
+/*Do the conversion of one packet in packet buffer slot*/
+int convert_one(int slot, const struct pcap_pkthdr *h, const u_char *bytes, struct d2t_pkt *out)
+{
 	struct packet		new;
 	struct const_packet	old;
 
-	/*Determine the link type for this packet*/
-	link_type=pcap_datalink(in);
-
 	/*create new libpcap header*/
-	memcpy(&nh, h, sizeof(struct pcap_pkthdr));
+	memcpy(&out->h, h, sizeof(struct pcap_pkthdr));
 
 	/*Setup packet structs*/
 	old.h=h;
 	old.length=h->caplen;
+	old.tail_len= h->len > h->caplen ? h->len - h->caplen : 0;	/*some writers record len < caplen*/
 	old.data=bytes;
 	old.dest_id=NULL;
 	old.src_id=NULL;
-	new.h=&nh;
-	new.length=MAX_PACKET;
+	new.h=&out->h;
 	new.dest_id=NULL;
 	new.src_id=NULL;
 
-	/*create buffer for new packet*/
-	new.data=ndata=malloc(MAX_PACKET);
-	if(ndata==NULL){
-		dbgprintf(0,"Error: Couldn't allocate Memory\n");
-		exit(1);
-	}
+	/*get buffer for new packet, large enough for jumbo frames and GSO segments*/
+	new.data=packet_buffer(slot, h->caplen + PKT_SLACK);
+	new.length=h->caplen + PKT_SLACK;
 
-	/*make sure the packet is all zero*/
-	memset(new.data, 0, MAX_PACKET);
+	/*make sure the headers are all zero. Only headers are built in the
+	 * buffer, the payload stays in the input packet*/
+	memset(new.data, 0, new.length < MAX_PACKET ? new.length : MAX_PACKET);
 	
 	/*do all the fancy conversions*/
-	if(!do_encap(link_type, &new, &old)){
-		free(ndata);
-		return;
+	if(!do_encap(d2t->link, &new, &old)){
+		return 0;
 	}
 
-	/*save packet*/
-	pcap_dump(user,&nh, ndata);
+	/*headers in the buffer, payload in the input packet*/
+	out->data=new.data;
+	out->data_len=new.length - new.tail_len;
+	if(out->data_len > out->h.caplen){
+		out->data_len=out->h.caplen;
+	}
+	out->tail=new.tail;
+	out->tail_len=out->h.caplen - out->data_len;
+return 1;
+}
 
-	free(ndata);
-return;
+/*Write a packet record to the output capture. Like pcap_dump(), but the
+ * record is gathered from the rebuilt headers and the payload in the input
+ * packet, so the payload is never copied into a packet buffer*/
+void dump_packet(pcap_dumper_t *d, const struct d2t_pkt *pkt)
+{
+	FILE		*f;
+	struct{
+		int32_t		tv_sec;
+		int32_t		tv_usec;
+		u_int32_t	caplen;
+		u_int32_t	len;
+	}			rec;	/*On-disk record header*/
+
+	f=pcap_dump_file(d);
+	rec.tv_sec=pkt->h.ts.tv_sec;
+	rec.tv_usec=pkt->h.ts.tv_usec;
+	rec.caplen=pkt->h.caplen;
+	rec.len=pkt->h.len;
+
+	fwrite(&rec, sizeof(rec), 1, f);
+	fwrite(pkt->data, 1, pkt->data_len, f);
+	if(pkt->tail_len > 0){
+		fwrite(pkt->tail, 1, pkt->tail_len, f);
+	}
+}
+
+/*Return packet buffer slot of the current context, at least len bytes long.
+ * Buffers are reused for every packet and only grow, so large captures don't
+ * malloc per packet*/
+u_char* packet_buffer(int slot, int len)
+{
+	u_char			*tmp;
+
+	if(slot >= d2t->nbufs){
+		d2t->bufs=realloc(d2t->bufs, (slot + 1)*sizeof(u_char*));
+		d2t->buf_lens=realloc(d2t->buf_lens, (slot + 1)*sizeof(int));
+		if(d2t->bufs==NULL || d2t->buf_lens==NULL){
+			dbgprintf(0,"Error: Couldn't allocate Memory\n");
+			exit(1);
+		}
+		for(int i=d2t->nbufs; i <= slot; i++){
+			d2t->bufs[i]=NULL;
+			d2t->buf_lens[i]=0;
+		}
+		d2t->nbufs=slot + 1;
+	}
+	if(len > d2t->buf_lens[slot]){
+		if(len < MAX_PACKET){
+			len=MAX_PACKET;
+		}
+		tmp=realloc(d2t->bufs[slot], len);
+		if(tmp==NULL){
+			dbgprintf(0,"Error: Couldn't allocate Memory\n");
+			exit(1);
+		}
+		d2t->bufs[slot]=tmp;
+		d2t->buf_lens[slot]=len;
+	}
+return d2t->bufs[slot];
 }
 
 /*do all the dccp to tcp conversions*/
@@ -218,18 +310,18 @@ int convert_packet(struct packet *new, const struct const_packet* old)
 	struct dccp_hdr_ext 		*dccphex;
 	struct hcon					*h1=NULL;
 	struct hcon					*h2=NULL;
-	char buf1[100];
-	char buf2[100];
+	enum prof_stage				prof;
+	int							ret;
 
 	/*Safety checks*/
+	d2t->av.valid=0;
 	if(!new || !old || !new->data || !old->data || !new->h || !old->h){
 		dbgprintf(0,"Error:  Convert Packet Function given bad data!\n");
-		exit(1);
 		return 0;
 	}
 	if(old->length < (sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext))
 												|| new->length < sizeof(struct dccp_hdr)){
-		dbgprintf(0, "Error: DCCP Packet Too short!\n");
+		warnprintf(NULL, WARN_TRUNCATED, "Error: DCCP Packet Too short!\n");
 		return 0;
 	}
 
@@ -243,13 +335,16 @@ int convert_packet(struct packet *new, const struct const_packet* old)
 
 	/*Ensure packet is at least as large as DCCP header*/
 	if(old->length < dccph->dccph_doff*4){
-		dbgprintf(0, "Error: DCCP Header truncated\n");
+		warnprintf(NULL, WARN_TRUNCATED, "Error: DCCP Header truncated\n");
 		return 0;
 	}
 
 	/*Get Hosts*/
-	if(get_host(new->src_id, new->dest_id, new->id_len, dccph->dccph_sport,
-			dccph->dccph_dport, dccph->dccph_type,&h1, &h2)){
+	prof=PROF_ENTER(PROF_HOST);
+	ret=get_host(new->src_id, new->dest_id, new->id_len, dccph->dccph_sport,
+			dccph->dccph_dport, dccph->dccph_type,&h1, &h2);
+	PROF_LEAVE(prof);
+	if(ret){
 		dbgprintf(0,"Error: Can't Get Hosts!\n");
 		return 0;
 	}
@@ -258,14 +353,12 @@ int convert_packet(struct packet *new, const struct const_packet* old)
 		return 0;
 	}
 	if(h1->state==IGNORE || h2->state==IGNORE){
-		if(old->print_id){
-			dbgprintf(2,"Ignoring packet between %s:%i and %s:%i\n",
-				old->print_id(buf1,100,old->src_id,old->id_len),ntohs(dccph->dccph_sport),
-				old->print_id(buf2,100,old->dest_id,old->id_len), ntohs(dccph->dccph_dport));
-		}else{
-			dbgprintf(2,"Ignoring packet between %i and %i\n",
-					ntohs(dccph->dccph_sport), ntohs(dccph->dccph_dport));
-		}
+		dbgprintf(2,"Ignoring packet between %s:%i and %s:%i\n",
+			host_name(h1),ntohs(dccph->dccph_sport), host_name(h2), ntohs(dccph->dccph_dport));
+		return 0;
+	}
+	if(d2t->counting){
+		filter_packet(old, h1);
 		return 0;
 	}
 
@@ -277,11 +370,14 @@ int convert_packet(struct packet *new, const struct const_packet* old)
 	tcph->urg_ptr=0;
 
 	/*Adjust TCP advertised window size*/
-	if(!yellow){
+	if(!d2t->yellow){
 		tcph->window=htons(30000);
 	}
 
 	/*Process DCCP Packet Types*/
+	if(dccph->dccph_type <= DCCP_PKT_SYNCACK){
+		(void)PROF_ENTER(PROF_HANDLE + dccph->dccph_type);
+	}
 	switch(dccph->dccph_type){
 		case DCCP_PKT_REQUEST:
 			dbgprintf(2,"Packet Type: Request\n");
@@ -343,25 +439,58 @@ int convert_packet(struct packet *new, const struct const_packet* old)
 			}
 			break;
 		default:
-			dbgprintf(0,"Invalid DCCP Packet!!\n");
+			warnprintf(h1, WARN_BAD_TYPE, "Invalid DCCP Packet!!\n");
 			return 0;
 			break;
 	}
 
-	/*Compute TCP checksums*/
-	if(new->id_len==IP4_ADDR_LEN){
+	/*Drop connections of other CCIDs as soon as the CCID is known*/
+	if(d2t->filter && d2t->filter->ccid!=UNKNOWN && !filter_ccid(h1, h2)){
+		return 0;
+	}
+
+	/*Compute TCP checksums. Payload that wasn't copied is checksummed in place*/
+	(void)PROF_ENTER(PROF_CHECKSUM);
+	if(new->tail_cap < new->tail_len){
+		tcph->check=0;
+		dbgprintf(2,"Payload not captured, can't do checksums\n");
+	}else if(new->id_len==IP4_ADDR_LEN){
 			tcph->check=0;
-			tcph->check=ipv4_pseudohdr_chksum(new->data,
-					new->length, new->dest_id, new->src_id, 6);
+			tcph->check=ipv4_pseudohdr_chksum_split(new->data, new->length - new->tail_len,
+					new->tail, new->tail_len, new->dest_id, new->src_id, 6);
 	}else if(new->id_len==IP6_ADDR_LEN){
 			tcph->check=0;
-			tcph->check=ipv6_pseudohdr_chksum(new->data,
-					new->length, new->dest_id, new->src_id, 6);
+			tcph->check=ipv6_pseudohdr_chksum_split(new->data, new->length - new->tail_len,
+					new->tail, new->tail_len, new->dest_id, new->src_id, 6);
 	}else{
 		tcph->check=0;
 		dbgprintf(2,"Unknown ID Length, can't do checksums\n");
 	}
 
+	/*Update statistics*/
+	if(d2t->stats || d2t->xplot || d2t->columns){
+		(void)PROF_ENTER(PROF_OUTPUT);
+	}
+	if(d2t->stats){
+		stats_packet(old, h1, h2);
+	}
+
+	/*Time sequence graphs*/
+	if(d2t->xplot){
+		xplot_packet(new, h1, h2);
+	}
+
+	/*Columnar export*/
+	if(d2t->columns){
+		columns_packet(new, old, h1);
+	}
+
+	/*Closed on both sides: give back the tables*/
+	if(h1->state==CLOSE && h2->state==CLOSE){
+		close_connection(d2t->last_conn);
+	}
+
+	PROF_LEAVE(prof);
 	return 1;
 }
 
@@ -386,7 +515,7 @@ int handle_request(struct packet* new, const struct const_packet* old, struct hc
 	dccphex=(struct dccp_hdr_ext*)(old->data+sizeof(struct dccp_hdr));
 
 	/*determine data length*/
-	datalength=old->length - dccph->dccph_doff*4;
+	datalength=old->length + old->tail_len - dccph->dccph_doff*4;
 
 	/*Process DCCP Options*/
 	dccpopt=old->data + sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext)+sizeof(struct dccp_hdr_request);
@@ -396,7 +525,7 @@ int handle_request(struct packet* new, const struct const_packet* old, struct hc
 	}
 
 	/*Do conversion*/
-	if(yellow){
+	if(d2t->yellow){
 		tcph->window=htons(0);
 	}
 	tcph->ack_seq=htonl(0);
@@ -411,7 +540,7 @@ int handle_request(struct packet* new, const struct const_packet* old, struct hc
 	tcph->rst=0;
 
 	/* add Sack-permitted option, if relevant*/
-	if(sack){
+	if(d2t->sack){
 		tcpopt=(u_char*)(new->data + tcph->doff*4);
 		*tcpopt=4;
 		tcpopt++;
@@ -457,11 +586,11 @@ int handle_response(struct packet* new, const struct const_packet* old, struct h
 
 	/*Do conversion*/
 	if(h2->state!=OPEN){
-		dbgprintf(0,"Warning: DCCP Response without a Request!!\n");
+		warnprintf(h2, WARN_NO_REQUEST, "Warning: DCCP Response without a Request!!\n");
 	}
 	tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low),h1));
 	h1->high_ack=ntohl(tcph->ack_seq);
-	if(yellow){
+	if(d2t->yellow){
 		tcph->window=htons(0);
 	}
 	if(h1->state==INIT){
@@ -473,7 +602,7 @@ int handle_response(struct packet* new, const struct const_packet* old, struct h
 	tcph->rst=0;
 
 	/* add Sack-permitted option, if relevant*/
-	if(sack){
+	if(d2t->sack){
 		tcpopt=(u_char*)(new->data + tcph->doff*4);
 		*tcpopt=4;
 		*(tcpopt+1)=2;
@@ -494,7 +623,6 @@ int handle_dataack(struct packet* new, const struct const_packet* old, struct hc
 	int 						datalength;
 	int							optlen;
 	const u_char* 				pd;
-	u_char* 					npd;
 	const u_char*				dccpopt;
 
 	/*length check*/
@@ -508,8 +636,8 @@ int handle_dataack(struct packet* new, const struct const_packet* old, struct hc
 	dccphex=(struct dccp_hdr_ext*)(old->data+sizeof(struct dccp_hdr));
 	dccphack=(struct dccp_hdr_ack_bits*)(old->data+ sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext));
 
-	/*determine data length*/
-	datalength=old->length - dccph->dccph_doff*4;
+	/*determine data length, including any that wasn't captured*/
+	datalength=old->length + old->tail_len - dccph->dccph_doff*4;
 	pd=old->data + dccph->dccph_doff*4;
 
 	/*Process DCCP Options*/
@@ -520,19 +648,19 @@ int handle_dataack(struct packet* new, const struct const_packet* old, struct hc
 	}
 
 	/*Do Conversion*/
-	if(green){
+	if(d2t->green){
 		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low),h1));
 	}else{
-		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph),h1));
+		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph, h1),h1));
 	}
 	h1->high_ack=ntohl(tcph->ack_seq);
 	tcph->seq=htonl(add_new_seq(h1, ntohl(dccphex->dccph_seq_low),datalength, dccph->dccph_type));
-	if(yellow){
-		tcph->window=htons(-interp_ack_vect((u_char*)dccph)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
+	if(d2t->yellow){
+		tcph->window=htons(-interp_ack_vect((u_char*)dccph, h1)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
 	}
-	if(sack){
-		if(sack!=2 || interp_ack_vect((u_char*)dccph)){
-			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, (u_char*)dccph, ntohl(dccphack->dccph_ack_nr_low),h1);
+	if(d2t->sack){
+		if(d2t->sack!=2 || interp_ack_vect((u_char*)dccph, h1)){
+			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, read_ack_vect((u_char*)dccph, h1), ntohl(dccphack->dccph_ack_nr_low),h1);
 		}
 	}
 	tcph->syn=0;
@@ -540,9 +668,10 @@ int handle_dataack(struct packet* new, const struct const_packet* old, struct hc
 	tcph->fin=0;
 	tcph->rst=0;
 
-	/*copy data*/
-	npd=new->data + tcph->doff*4;
-	memcpy(npd, pd, datalength);
+	/*Reference data in the old packet instead of copying it*/
+	new->tail_len=datalength;
+	new->tail=pd;
+	new->tail_cap=datalength - old->tail_len;
 
 	/*calculate length*/
 	new->length=tcph->doff*4 + datalength;
@@ -577,22 +706,22 @@ int handle_ack(struct packet* new, const struct const_packet* old, struct hcon*
 	}
 
 	/*Do Conversion*/
-	if(green){
+	if(d2t->green){
 		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low),h1));
 	}else{
-		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph),h1));
+		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph, h1),h1));
 	}
 	h1->high_ack=ntohl(tcph->ack_seq);
 	tcph->seq=htonl(add_new_seq(h1, ntohl(dccphex->dccph_seq_low),1,dccph->dccph_type));
-	if(yellow){
-		tcph->window=htons(-interp_ack_vect((u_char*)dccph)*1400);
-		if(-interp_ack_vect((u_char*)dccph)*1400 > 65535){
-			dbgprintf(0,"Note: TCP Window Overflow @ %d.%d\n", (int)old->h->ts.tv_sec, (int)old->h->ts.tv_usec);
+	if(d2t->yellow){
+		tcph->window=htons(-interp_ack_vect((u_char*)dccph, h1)*1400);
+		if(-interp_ack_vect((u_char*)dccph, h1)*1400 > 65535){
+			warnprintf(h1, WARN_WINDOW, "Note: TCP Window Overflow @ %d.%d\n", (int)old->h->ts.tv_sec, (int)old->h->ts.tv_usec);
 		}
 	}
-	if(sack){
-		if(sack!=2 || interp_ack_vect((u_char*)dccph)){
-			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, (u_char*)dccph, ntohl(dccphack->dccph_ack_nr_low),h1);
+	if(d2t->sack){
+		if(d2t->sack!=2 || interp_ack_vect((u_char*)dccph, h1)){
+			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, read_ack_vect((u_char*)dccph, h1), ntohl(dccphack->dccph_ack_nr_low),h1);
 		}
 	}
 
@@ -634,19 +763,19 @@ int handle_closereq(struct packet* new, const struct const_packet* old, struct h
 	}
 
 	/*Do Conversion*/
-	if(green){
+	if(d2t->green){
 		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low),h1));
 	}else{
-		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph),h1));
+		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph, h1),h1));
 	}
 	h1->high_ack=ntohl(tcph->ack_seq);
 	tcph->seq=htonl(add_new_seq(h1, ntohl(dccphex->dccph_seq_low),1,dccph->dccph_type));
-	if(yellow){
-		tcph->window=htons(-interp_ack_vect((u_char*)dccph)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
+	if(d2t->yellow){
+		tcph->window=htons(-interp_ack_vect((u_char*)dccph, h1)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
 	}
-	if(sack){
-		if(sack!=2 || interp_ack_vect((u_char*)dccph)){
-			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, (u_char*)dccph, ntohl(dccphack->dccph_ack_nr_low),h1);
+	if(d2t->sack){
+		if(d2t->sack!=2 || interp_ack_vect((u_char*)dccph, h1)){
+			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, read_ack_vect((u_char*)dccph, h1), ntohl(dccphack->dccph_ack_nr_low),h1);
 		}
 	}
 
@@ -689,19 +818,19 @@ int handle_close(struct packet* new, const struct const_packet* old, struct hcon
 
 	/*Do Conversion*/
 	update_state(h1,CLOSE);
-	if(green){
+	if(d2t->green){
 		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low),h1));
 	}else{
-		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph),h1));
+		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph, h1),h1));
 	}
 	h1->high_ack=ntohl(tcph->ack_seq);
 	tcph->seq=htonl(add_new_seq(h1, ntohl(dccphex->dccph_seq_low),1,dccph->dccph_type));
-	if(yellow){
-		tcph->window=htons(-interp_ack_vect((u_char*)dccph)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
+	if(d2t->yellow){
+		tcph->window=htons(-interp_ack_vect((u_char*)dccph, h1)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
 	}
-	if(sack){
-		if(sack!=2 || interp_ack_vect((u_char*)dccph)){
-			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, (u_char*)dccph, ntohl(dccphack->dccph_ack_nr_low),h1);
+	if(d2t->sack){
+		if(d2t->sack!=2 || interp_ack_vect((u_char*)dccph, h1)){
+			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, read_ack_vect((u_char*)dccph, h1), ntohl(dccphack->dccph_ack_nr_low),h1);
 		}
 	}
 
@@ -746,19 +875,19 @@ int handle_reset(struct packet* new, const struct const_packet* old, struct hcon
 	if(h2->state==CLOSE){
 		update_state(h1,CLOSE);
 	}
-	if(green){
+	if(d2t->green){
 		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low),h1));
 	}else{
-		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph),h1));
+		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph, h1),h1));
 	}
 	h1->high_ack=ntohl(tcph->ack_seq);
 	tcph->seq=htonl(add_new_seq(h1, ntohl(dccphex->dccph_seq_low),1,dccph->dccph_type));
-	if(yellow){
-		tcph->window=htons(-interp_ack_vect((u_char*)dccph)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
+	if(d2t->yellow){
+		tcph->window=htons(-interp_ack_vect((u_char*)dccph, h1)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
 	}
-	if(sack){
-		if(sack!=2 || interp_ack_vect((u_char*)dccph)){
-			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, (u_char*)dccph, ntohl(dccphack->dccph_ack_nr_low),h1);
+	if(d2t->sack){
+		if(d2t->sack!=2 || interp_ack_vect((u_char*)dccph, h1)){
+			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, read_ack_vect((u_char*)dccph, h1), ntohl(dccphack->dccph_ack_nr_low),h1);
 		}
 	}
 
@@ -800,21 +929,21 @@ int handle_sync(struct packet* new, const struct const_packet* old, struct hcon*
 	}
 
 	/*Do Conversion*/
-	if(green){
+	if(d2t->green){
 		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low),h1));
 	}else{
-		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph),h1));
+		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph, h1),h1));
 	}
 	h1->high_ack=ntohl(tcph->ack_seq);
 	tcph->seq=htonl(add_new_seq(h1, ntohl(dccphex->dccph_seq_low),0,dccph->dccph_type));
-	if(yellow){
-		tcph->window=htons(-interp_ack_vect((u_char*)dccph)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
+	if(d2t->yellow){
+		tcph->window=htons(-interp_ack_vect((u_char*)dccph, h1)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
 	}else{
 		tcph->window=htons(0);
 	}
-	if(sack){
-		if(sack!=2 || interp_ack_vect((u_char*)dccph)){
-			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, (u_char*)dccph, ntohl(dccphack->dccph_ack_nr_low),h1);
+	if(d2t->sack){
+		if(d2t->sack!=2 || interp_ack_vect((u_char*)dccph, h1)){
+			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, read_ack_vect((u_char*)dccph, h1), ntohl(dccphack->dccph_ack_nr_low),h1);
 		}
 	}
 
@@ -856,21 +985,21 @@ int handle_syncack(struct packet* new, const struct const_packet* old, struct hc
 	}
 
 	/*Do Conversion*/
-	if(green){
+	if(d2t->green){
 		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low),h1));
 	}else{
-		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph),h1));
+		tcph->ack_seq=htonl(convert_ack(h2,ntohl(dccphack->dccph_ack_nr_low)+interp_ack_vect((u_char*)dccph, h1),h1));
 	}
 	h1->high_ack=ntohl(tcph->ack_seq);
 	tcph->seq=htonl(add_new_seq(h1, ntohl(dccphex->dccph_seq_low),0,dccph->dccph_type));
-	if(yellow){
-		tcph->window=htons(-interp_ack_vect((u_char*)dccph)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
+	if(d2t->yellow){
+		tcph->window=htons(-interp_ack_vect((u_char*)dccph, h1)*acked_packet_size(h2, ntohl(dccphack->dccph_ack_nr_low)));
 	}else{
 		tcph->window=htons(0);
 	}
-	if(sack){
-		if(sack!=2 || interp_ack_vect((u_char*)dccph)){
-			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, (u_char*)dccph, ntohl(dccphack->dccph_ack_nr_low),h1);
+	if(d2t->sack){
+		if(d2t->sack!=2 || interp_ack_vect((u_char*)dccph, h1)){
+			ack_vect2sack(h2, tcph, (u_char*)tcph + tcph->doff*4, read_ack_vect((u_char*)dccph, h1), ntohl(dccphack->dccph_ack_nr_low),h1);
 		}
 	}
 
@@ -892,7 +1021,6 @@ int handle_data(struct packet* new, const struct const_packet* old, struct hcon*
 	int 						datalength;
 	int							optlen;
 	const u_char* 				pd;
-	u_char* 					npd;
 	const u_char*				dccpopt;
 
 	/*length check*/
@@ -905,8 +1033,8 @@ int handle_data(struct packet* new, const struct const_packet* old, struct hcon*
 	dccph=(struct dccp_hdr*)old->data;
 	dccphex=(struct dccp_hdr_ext*)(old->data+sizeof(struct dccp_hdr));
 
-	/*determine data length*/
-	datalength=old->length - dccph->dccph_doff*4;
+	/*determine data length, including any that wasn't captured*/
+	datalength=old->length + old->tail_len - dccph->dccph_doff*4;
 	pd=old->data + dccph->dccph_doff*4;
 
 	/*Process DCCP Options*/
@@ -924,23 +1052,36 @@ int handle_data(struct packet* new, const struct const_packet* old, struct hcon*
 	tcph->fin=0;
 	tcph->rst=0;
 
-	/*copy data*/
-	npd=new->data + tcph->doff*4;
-	memcpy(npd, pd, datalength);
+	/*Reference data in the old packet instead of copying it*/
+	new->tail_len=datalength;
+	new->tail=pd;
+	new->tail_cap=datalength - old->tail_len;
 
 	/*calculate length*/
 	new->length=tcph->doff*4 + datalength;
 	return 1;
 }
 
+/*Parse DCCP options, timed as its own profiling stage*/
 int parse_options(const u_char* opt_start, int len, const struct const_packet* pkt,
 																	struct hcon* A,	struct hcon* B)
+{
+	enum prof_stage	prof;
+	int				ret;
+
+	prof=PROF_ENTER(PROF_OPTIONS);
+	ret=parse_option_list(opt_start, len, pkt, A, B);
+	PROF_LEAVE(prof);
+return ret;
+}
+
+/*Walk the DCCP options of a packet*/
+int parse_option_list(const u_char* opt_start, int len, const struct const_packet* pkt,
+																	struct hcon* A,	struct hcon* B)
 {
 	int optlen;
 	int length;
 	const u_char* opt;
-	char buf1[100];
-	char buf2[100];
 
 	/*setup pointer to DCCP options and determine how long the options are*/
 	optlen=len;
@@ -958,11 +1099,11 @@ int parse_options(const u_char* opt_start, int len, const struct const_packet* p
 		/*Check option length*/
 		length=*(opt+1);
 		if(length > optlen){
-			dbgprintf(0, "Warning: Option would extend into packet data\n");
+			warnprintf(A, WARN_OPT_OVERRUN, "Warning: Option would extend into packet data\n");
 			return 0;
 		}
 		if(length < 2){
-			dbgprintf(0, "Warning: Bad Option!\n");
+			warnprintf(A, WARN_BAD_OPTION, "Warning: Bad Option!\n");
 			return 0;
 		}
 
@@ -970,14 +1111,8 @@ int parse_options(const u_char* opt_start, int len, const struct const_packet* p
 		if(*opt==38 || *opt==39){
 			if(B->type==UNKNOWN){
 				B->type=CCID2;
-				if(pkt->print_id){
-					dbgprintf(1,"Half-connection from %s:%i to %s:%i probably using CCID 2\n",
-						pkt->print_id(buf1,100,pkt->dest_id,pkt->id_len),ntohs(B->port),
-						pkt->print_id(buf2,100,pkt->src_id,pkt->id_len), ntohs(A->port));
-				}else{
-					dbgprintf(1,"Half-connection from  port %i to %i probably using CCID 2\n",
-						ntohs(B->port),ntohs(A->port));
-				}
+				dbgprintf(1,"Half-connection from %s:%i to %s:%i probably using CCID 2\n",
+					host_name(B),ntohs(B->port), host_name(A), ntohs(A->port));
 			}
 		}
 
@@ -985,14 +1120,8 @@ int parse_options(const u_char* opt_start, int len, const struct const_packet* p
 		if(*opt==37){
 			if(B->type==UNKNOWN){
 				B->type=CCID3;
-				if(pkt->print_id){
-					dbgprintf(1,"Half-connection from %s:%i to %s:%i probably using CCID 3\n",
-						pkt->print_id(buf1,100,pkt->dest_id,pkt->id_len),ntohs(B->port),
-						pkt->print_id(buf2,100,pkt->src_id,pkt->id_len), ntohs(A->port));
-				}else{
-					dbgprintf(1,"Half-connection from  port %i to %i probably using CCID 3\n",
-						ntohs(B->port),ntohs(A->port));
-				}
+				dbgprintf(1,"Half-connection from %s:%i to %s:%i probably using CCID 3\n",
+					host_name(B),ntohs(B->port), host_name(A), ntohs(A->port));
 			}
 		}
 
@@ -1034,8 +1163,6 @@ int process_feature(const u_char* feat, int len, int confirm, int L,
 {
 	const u_char* val;
 	int ccid;
-	char buf1[100];
-	char buf2[100];
 
 	val=feat+1;
 
@@ -1056,24 +1183,12 @@ int process_feature(const u_char* feat, int len, int confirm, int L,
 				}
 				if(L==TRUE){
 					B->type=ccid;
-					if(pkt->print_id){
-						dbgprintf(1,"Half-connection from %s:%i to %s:%i using CCID %i\n",
-							pkt->print_id(buf1,100,pkt->dest_id,pkt->id_len),ntohs(B->port),
-							pkt->print_id(buf2,100,pkt->src_id,pkt->id_len), ntohs(A->port), *val);
-					}else{
-						dbgprintf(1,"Half-connection from  port %i to %i using CCID %i\n",
-							ntohs(B->port),ntohs(A->port), *val);
-					}
+					dbgprintf(1,"Half-connection from %s:%i to %s:%i using CCID %i\n",
+						host_name(B),ntohs(B->port), host_name(A), ntohs(A->port), *val);
 				}else{
 					A->type=ccid;
-					if(pkt->print_id){
-						dbgprintf(1,"Half-connection from %s:%i to %s:%i using CCID %i\n",
-							pkt->print_id(buf1,100,pkt->src_id,pkt->id_len),ntohs(A->port),
-							pkt->print_id(buf2,100,pkt->dest_id,pkt->id_len), ntohs(B->port), *val);
-					}else{
-						dbgprintf(1,"Half-connection from  port %i to %i using CCID %i\n",
-							ntohs(A->port),ntohs(B->port), *val);
-					}
+					dbgprintf(1,"Half-connection from %s:%i to %s:%i using CCID %i\n",
+						host_name(A),ntohs(A->port), host_name(B), ntohs(B->port), *val);
 				}
 			}
 			break;
@@ -1093,155 +1208,69 @@ int process_feature(const u_char* feat, int len, int confirm, int L,
 }
 
 /*Ack Vector to SACK Option*/
-void ack_vect2sack(struct hcon *hcn, struct tcphdr *tcph, u_char* tcpopts, u_char* dccphdr,
+void ack_vect2sack(struct hcon *hcn, struct tcphdr *tcph, u_char* tcpopts, const struct ack_vect *av,
 																d_seq_num dccpack, struct hcon* o_hcn)
 {
-	int hdrlen=((struct dccp_hdr*)dccphdr)->dccph_doff*4;
-	int optlen;
-	int len;
-	int tmp;
-	d_seq_num bp;
-	u_char* temp;
-	u_char* opt;
-	u_char* cur;
-	u_char* tlen;
-	u_int32_t bL=0;
-	u_int32_t bR;
-	u_int32_t* pL;
-	u_int32_t* pR;
-	int num_blocks;
-	int cont;
-	int isopt;
-
-	/*setup pointer to DCCP options and determine how long the options are*/
-	optlen=hdrlen-sizeof(struct dccp_hdr) - sizeof(struct dccp_hdr_ext) - sizeof(struct dccp_hdr_ack_bits);
-	opt=dccphdr + sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext) + sizeof(struct dccp_hdr_ack_bits);
-
-	if(optlen<=0){
+	const struct av_run	*runs=av->runs;
+	int					n=av->n;
+	int					last_loss=-1;
+	int					max_blocks;
+	int					num_blocks=0;
+	u_int32_t			edge;
+	u_char*				opt;
+
+	/*Only packets received above the oldest loss need SACKing, the
+	 * rest are covered by the cumulative ACK*/
+	for(int i=0; i < n; i++){
+		if(runs[i].state==AV_LOST || runs[i].state==AV_ECN){
+			last_loss=i;
+		}
+	}
+	if(last_loss < 0){
 		return;
 	}
 
-	/*setup tcp pointers*/
-	num_blocks=4;
-	*tcpopts=5;
-	tlen=tcpopts+1;
-	temp=tlen;
-	temp++;
-	pL=(u_int32_t*)temp;
-	pR=pL+1;
-
-	/*setup tcp control variables*/
-	bp=dccpack;
-	cont=0;
-	*tlen=2;
-	isopt=0;
-
-	/*parse options*/
-	while(optlen > 0){
+	/*Blocks that fit in the remaining option space (NOP, NOP, kind, length, 8 bytes per block)*/
+	max_blocks=(MAX_TCP_OPTS - (tcph->doff*4 - sizeof(struct tcphdr)) - 4)/8;
+	if(max_blocks > MAX_SACK_BLOCKS){
+		max_blocks=MAX_SACK_BLOCKS;
+	}
+	if(max_blocks <= 0){
+		return;
+	}
 
-		/*One byte options (no length)*/
-		if(*opt< 32){
-			optlen--;
-			opt++;
+	/*Blocks in the order received, so the newest come first (RFC 2018)*/
+	opt=tcpopts + 4;
+	for(int i=0; i < last_loss && num_blocks < max_blocks; i++){
+		if(runs[i].state!=AV_RECEIVED){
 			continue;
 		}
-
-		len=*(opt+1);
-		if(len > optlen){
-			dbgprintf(0, "Warning: Option would extend into packet data\n");
-			break;
-		}
-
-		/*Ack Vector Option*/
-		if(*opt==38 || *opt==39){
-			tmp=len-2;
-			cur=opt+2;
-			/*loop through Vector*/
-			while(tmp > 0){
-				/*ack vector works BACKWARDS through time*/
-
-				if((*cur & 0xC0)==0xC0 || (*cur & 0xC0)==0x40){ //lost packet
-					if(cont){ /*end a SACK run, if one is started*/
-						bR=convert_ack(hcn, bp,o_hcn);
-						cont=0;
-						num_blocks--;
-						*pR=htonl(bR);
-						*pL=htonl(bL);
-						tcph->doff+=2;
-						*tlen+=8;
-						pL=pR+1;
-						pR=pL+1;
-					}
-					bp= bp - (*cur & 0x3F)- 1;
-				}
-
-				if((*cur & 0xC0)==0x00){ //received packet
-					if(!cont){ /*if no SACK run and we can start another one, do so*/
-						if(num_blocks>0){
-							bL=convert_ack(hcn, bp, o_hcn);
-							isopt=1;
-							cont=1;
-
-						}
-					}
-					bp =  bp -(*cur & 0x3F)- 1;
-				}
-				tmp--;
-				cur++;
-			}
-		}
-
-		optlen-=len;
-		opt+=len;
-	}
-
-	/*if we are in the middle of a SACK run, close it*/
-	if(cont){
-		bR=convert_ack(hcn, bp,o_hcn);
-		*pR=htonl(bR);
-		*pL=htonl(bL);
-		tcph->doff+=2;
-		*tlen+=8;
-		cont=0;
+		/*Left edge: just after the packet below the run. Right edge: just after its newest packet*/
+		edge=htonl(convert_ack(hcn, runs[i].top - runs[i].len, o_hcn));
+		memcpy(opt, &edge, 4);
+		edge=htonl(convert_ack(hcn, runs[i].top, o_hcn));
+		memcpy(opt+4, &edge, 4);
+		opt+=8;
+		num_blocks++;
+	}
+	if(num_blocks==0){
+		return;
 	}
 
-	/*adjust length if the option is actually added*/
-	if(isopt){
-		tcph->doff+=1;
-	}
+	/*Option header, padded with NOPs*/
+	tcpopts[0]=1;
+	tcpopts[1]=1;
+	tcpopts[2]=5;
+	tcpopts[3]=2 + 8*num_blocks;
+	tcph->doff+=1 + 2*num_blocks;
 return;
 }
 
-void version()
-{
-	dbgprintf(0, "dccp2tcp version %.1f\n",DCCP2TCP_VERSION);
-	dbgprintf(0, "Copyright (C) %i Samuel Jero <sj323707@ohio.edu>\n",COPYRIGHT_YEAR);
-	dbgprintf(0, "This program comes with ABSOLUTELY NO WARRANTY.\n");
-	dbgprintf(0, "This is free software, and you are welcome to\n");
-	dbgprintf(0, "redistribute it under certain conditions.\n");
-	exit(0);
-}
-
-/*Usage information for program*/
-void usage()
-{
-	dbgprintf(0,"Usage: dccp2tcp [-v] [-h] [-V] [-y] [-g] [-s] dccp_file tcp_file\n");
-	dbgprintf(0, "          -v   verbose. May be repeated for additional verbosity.\n");
-	dbgprintf(0, "          -V   Version information\n");
-	dbgprintf(0, "          -h   Help\n");
-	dbgprintf(0, "          -y   Yellow line is highest ACK\n");
-	dbgprintf(0, "          -g   Green line is highest ACK\n");
-	dbgprintf(0, "          -s   convert ACK Vectors to SACKS\n");
-	exit(0);
-}
-
-/*Debug Printf*/
-void dbgprintf(int level, const char *fmt, ...)
+/*Debug Printf. Only called through dbgprintf(), which checks the level*/
+void dbgprint(const char *fmt, ...)
 {
     va_list args;
-    if(debug>=level){
-    	va_start(args, fmt);
-    	vfprintf(stderr, fmt, args);
-    	va_end(args);
-    }
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
 }
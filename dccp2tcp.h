@@ -53,8 +53,18 @@ Notes:
 #include "checksums.h"
 
 
-#define MAX_PACKET 	1600	/*Maximum size of TCP packet */
+#define MAX_PACKET 	1600	/*Initial size of the packet buffer*/
+#define PKT_SLACK	64		/*Bytes a packet may grow by in conversion*/
+#define OUT_BUF_SZ	65536	/*stdio buffer of a TCP capture written to stdout*/
 #define	TBL_SZ		40000	/*Size of Sequence Number Table*/
+#define TBL_TAIL	256		/*Table entries kept after a connection closes*/
+#define CONN_SLAB	64		/*Connections allocated at a time*/
+#define LOOKUP_WIN	64		/*Table entries searched around the last lookup*/
+#define MAX_TCP_OPTS	40		/*Maximum length of TCP options*/
+#define MAX_SACK_BLOCKS	4		/*SACK blocks that fit in a TCP header*/
+#define STATS_INTERVAL	1		/*Goodput interval for statistics (seconds)*/
+#define XPLOT_FILES		128		/*Time sequence graph files kept open at a time*/
+#define WARN_SAMPLES	10		/*Warnings of each class printed before suppressing*/
 
 
 #define TRUE 1
@@ -71,6 +81,9 @@ struct packet{
 	u_char				*src_id; /*Source ID of packet*/
 	u_char				*dest_id;/*Destination ID of packet*/
 	char* 				(*print_id)(char* buf, int len, u_char* id, int id_len); /*Function to print ID*/
+	int					tail_len;/*Bytes at the end of the packet not stored in data*/
+	const u_char		*tail;	/*Location of those bytes (in the old packet)*/
+	int					tail_cap;/*Bytes of tail that were captured*/
 };
 
 /*Constant Packet structure*/
@@ -82,6 +95,7 @@ struct const_packet{
 	u_char					*src_id; /*Source ID of packet*/
 	u_char					*dest_id;/*Destination ID of packet*/
 	char* 					(*print_id)(char* buf, int len, u_char* id, int id_len); /*Function to print ID*/
+	int						tail_len;/*Bytes of the packet beyond length that weren't captured*/
 };
 
 /*Connection states*/
@@ -100,17 +114,84 @@ enum con_type{
 	CCID3,
 };
 
+/*Statistics output formats*/
+enum stats_fmt{
+	STATS_NONE,
+	STATS_CSV,
+	STATS_JSON,
+};
+
+/*Warning classes, counted by warn_count()*/
+enum warn_class{
+	WARN_UNINIT,		/*Connection uninitialized*/
+	WARN_MISSING,		/*Missing packet*/
+	WARN_MISSING_MANY,	/*More than 100 packets missing*/
+	WARN_SEQ_NOT_FOUND,	/*Sequence number not in table*/
+	WARN_OPT_OVERRUN,	/*Option would extend into packet data*/
+	WARN_BAD_OPTION,	/*Bad option*/
+	WARN_ACK_VECT,		/*Invalid or oversized Ack Vector*/
+	WARN_NO_REQUEST,	/*Response without a Request*/
+	WARN_WINDOW,		/*TCP window overflow*/
+	WARN_BAD_TYPE,		/*Invalid DCCP packet type*/
+	WARN_TRUNCATED,		/*DCCP packet too short or truncated*/
+	WARN_PROTOCOL,		/*Wrong or unknown protocol in an encapsulation*/
+	NUM_WARN,
+};
+
+/*Profiling stages, see prof.c*/
+enum prof_stage{
+	PROF_READ,			/*libpcap reading (between packets)*/
+	PROF_ENCAP,			/*do_encap() and packet setup*/
+	PROF_HOST,			/*get_host()*/
+	PROF_OPTIONS,		/*parse_options()*/
+	PROF_HANDLE,		/*handle_*(), one stage per DCCP packet type*/
+	PROF_CHECKSUM=PROF_HANDLE + DCCP_PKT_SYNCACK + 1,/*TCP checksums*/
+	PROF_OUTPUT,		/*Statistics, graphs and columns*/
+	PROF_DUMP,			/*Writing the TCP capture*/
+	NUM_PROF,
+};
+
+/*Half Connection statistics*/
+struct hstats{
+	struct timeval		first;		/*Time of first packet*/
+	struct timeval		last;		/*Time of last packet*/
+	u_int64_t			pkts;		/*Packets sent*/
+	u_int64_t			data_pkts;	/*Packets sent carrying data*/
+	u_int64_t			bytes;		/*Data bytes sent*/
+	u_int64_t			delivered;	/*Data bytes reported received by the other host*/
+	u_int64_t			lost;		/*Packets reported lost by the other host*/
+	u_int64_t			loss_runs;	/*Runs of consecutive lost packets*/
+	u_int64_t			ecn;		/*Packets reported received ECN marked (also delivered)*/
+	int					acked;		/*Have we seen an ACK for this host yet?*/
+	d_seq_num			ack_high;	/*Highest sequence number already accounted for*/
+	u_int64_t			rtt_cnt;	/*Number of RTT samples*/
+	double				rtt_min;	/*Minimum RTT (seconds)*/
+	double				rtt_max;	/*Maximum RTT (seconds)*/
+	double				rtt_sum;	/*Sum of RTT samples (seconds)*/
+	u_int64_t			*gput;		/*Data bytes delivered per STATS_INTERVAL*/
+	int					gput_len;	/*Number of intervals in gput*/
+	struct timeval		*sent;		/*Send time of each Sequence Number Table entry*/
+	int					last_slot;	/*Table entry of the last packet sent*/
+};
+
 /*Half Connection structure*/
 struct hcon{
+	int					num;	/*Half-connection number (connection*2 for A, +1 for B)*/
 	int					id_len;	/*Length of ID*/
-	u_char 				*id;	/*Host ID*/
+	u_char 				id[IP6_ADDR_LEN];/*Host ID*/
+	char				name[INET6_ADDRSTRLEN];/*Printable Host ID, formatted on first use*/
 	dccp_port 			port;	/*Host DCCP port*/
 	struct tbl			*table;	/*Host Sequence Number Table*/
 	int					size;	/*Size of Sequence Number Table*/
+	int					used;	/*Valid table entries (all of them once it has wrapped)*/
 	int					cur;	/*Current TCP Sequence Number*/
+	int					last;	/*Table entry of the last successful lookup*/
 	int					high_ack;/*Highest ACK seen*/
 	enum con_state		state;	/*Connection state*/
 	enum con_type		type;	/*Connection type*/
+	struct hstats		stats;	/*Statistics*/
+	struct xpl			*xpl;	/*Time sequence graph output*/
+	unsigned int		warns[NUM_WARN];/*Warnings about this half-connection*/
 };
 
 /*Connection structure*/
@@ -120,29 +201,223 @@ struct connection{
 	struct hcon			B;		/*Host B*/
 };
 
-/*sequence number table structure */
+/*sequence number table structure (12 bytes, size and type share a word)*/
 struct tbl{
-	d_seq_num 			old;	/*DCCP sequence number */
-	u_int32_t			new;	/*TCP sequence number */
-	int					size;	/*packet size*/
-	enum dccp_pkt_type 	type;	/*packet type*/
+	d_seq_num 			old;		/*DCCP sequence number */
+	u_int32_t			new;		/*TCP sequence number */
+	u_int32_t			size:24;	/*packet size*/
+	u_int32_t			type:8;		/*packet type (enum dccp_pkt_type)*/
+};
+
+/*Ack Vector states*/
+enum av_state{
+	AV_RECEIVED=0,
+	AV_ECN=1,		/*Received ECN marked*/
+	AV_INVALID=2,
+	AV_LOST=3,		/*Not received*/
+};
+
+/*A run of packets in the same state, decoded from an Ack Vector*/
+struct av_run{
+	d_seq_num			top;	/*Newest sequence number in the run*/
+	int					len;	/*Number of packets*/
+	u_char				state;	/*enum av_state*/
 };
 
-/*Option flags*/
-extern int debug;		/*set to 1 to turn on debugging information*/
-extern int yellow;		/*tcptrace yellow line as currently acked packet*/
-extern int green;		/*tcptrace green line as currently acked packet*/
-extern int sack;		/*add TCP SACKS*/
+#define AV_MAX_RUNS	1024	/*Ack Vector options can't hold more runs*/
 
-extern struct connection *chead;/*connection list*/
+/*A decoded Ack Vector (decode_ack_vect())*/
+struct ack_vect{
+	int					valid;		/*decoded for the packet being converted*/
+	int					n;			/*runs, -1 without an Ack Vector*/
+	int					additional;	/*minus the packets received since the oldest loss*/
+	unsigned int		lost;		/*packets reported lost*/
+	struct av_run		runs[AV_MAX_RUNS];/*runs, newest first*/
+};
+
+/*Connection and table allocation statistics*/
+struct alloc_stats{
+	int					conns;		/*Connections allocated*/
+	int					slabs;		/*Connection slabs allocated*/
+	int					tbl_alloc;	/*Tables malloc'ed*/
+	int					tbl_reuse;	/*Tables taken from the free list*/
+	int					tbl_retired;/*Tables returned to the free list*/
+	int					tbl_used;	/*Tables currently in use*/
+	int					tbl_peak;	/*Most tables in use at once*/
+};
+
+/*One end of a selected connection (see filter.c)*/
+struct filter_ep{
+	int					id_len;		/*Length of id, 0 for any address*/
+	u_char				id[IP6_ADDR_LEN];/*Address*/
+	int					port;		/*Port (host byte order), -1 for any port*/
+};
+
+/*Connection selection. A connection is converted if it matches any of sel
+ * (or there is none), has the CCID ccid (if set) and at least min_pkts
+ * packets and min_bytes bytes of data (if set)*/
+struct filter{
+	struct filter_ep	(*sel)[2];	/*Pairs of ends*/
+	int					nsel;		/*Number of pairs*/
+	enum con_type		ccid;		/*CCID, UNKNOWN for any*/
+	u_int64_t			min_pkts;	/*Minimum packets (both directions)*/
+	u_int64_t			min_bytes;	/*Minimum data bytes (both directions)*/
+};
+
+/*Profiling counters, see prof.c*/
+struct prof_state{
+	u_int64_t			ticks[NUM_PROF];/*Ticks spent in each stage*/
+	u_int64_t			calls[NUM_PROF];/*Times each stage was entered*/
+	enum prof_stage		cur;		/*Stage being charged*/
+	u_int64_t			last;		/*Tick of the last stage switch*/
+	u_int64_t			start_tick;	/*Tick at prof_start()*/
+	u_int64_t			start_ns;	/*Wall clock at prof_start()*/
+	u_int64_t			end_tick;	/*Tick at prof_finish()*/
+	u_int64_t			end_ns;		/*Wall clock at prof_finish()*/
+};
+
+/*Conversion context
+ * Everything one conversion needs: options, connections and I/O. Any number
+ * of contexts can exist in a process. The conversion code uses the thread's
+ * current context, d2t, which every ctx_*() function sets to its argument,
+ * so a context must only be used by one thread at a time.
+ */
+struct d2t_ctx{
+	/*Options, set between ctx_new() and the first packet*/
+	int					debug;		/*set to 1 to turn on debugging information*/
+	int					yellow;		/*tcptrace yellow line as currently acked packet*/
+	int					green;		/*tcptrace green line as currently acked packet*/
+	int					sack;		/*add TCP SACKS*/
+	enum stats_fmt		stats;		/*compute statistics instead of writing a TCP capture*/
+	char				*xplot;		/*file name prefix for time sequence graphs*/
+	int					xplot_points;/*maximum points per time sequence graph*/
+	char				*columns;	/*file for columnar per-packet export*/
+	int					nopcap;		/*don't write a TCP capture*/
+	int					headers_only;/*don't copy payload into the TCP capture*/
+	int					profile;	/*count time spent in each conversion stage*/
+	int					flush_packets;/*flush the output every N packets written (0: off)*/
+	int					flush_ms;	/*flush the output every M ms of capture time (0: off)*/
+	const struct filter	*filter;	/*connections to convert (NULL: all)*/
+
+	/*I/O, also set before the first packet*/
+	int					link;		/*libpcap link type of the input*/
+	pcap_dumper_t		*out;		/*TCP capture written by handle_packet() (or NULL)*/
+	int					unflushed;	/*packets written since the last flush*/
+	struct timeval		flushed;	/*capture time of the last flush*/
+
+	/*Connections*/
+	struct connection	*chead;		/*connection list*/
+	struct connection	*ctail;		/*last connection in the list*/
+	struct connection	*last_conn;	/*connection of the last packet (get_host() cache)*/
+	struct conn_slab	*slabs;		/*connection slabs, newest first*/
+	struct tbl_free		*tbl_free;	/*sequence number tables for reuse*/
+	int					num_hcons;	/*half-connections created so far*/
+	struct alloc_stats	alloc;		/*allocation statistics*/
+	struct filter_ep	(*keep)[2];	/*connections big enough for filter (filter_count())*/
+	int					nkeep;		/*number of connections in keep*/
+	int					counting;	/*only count packets per connection (filter_count())*/
+
+	/*Packet buffers, one per packet of a batch*/
+	u_char				**bufs;
+	int					*buf_lens;
+	int					nbufs;
+	struct ack_vect		av;			/*Ack Vector of the packet being converted*/
+
+	/*Diagnostics and outputs*/
+	u_int64_t			warn_total[NUM_WARN];/*occurrences of each warning*/
+	int					error;		/*an output failed and was abandoned (see ctx_finish())*/
+	struct prof_state	prof;		/*profiling counters*/
+	struct col_state	*cols;		/*columnar export*/
+	struct xpl			*xpl_head;	/*graphs with an open file, most recently used first*/
+	struct xpl			*xpl_tail;	/*least recently used graph with an open file*/
+	int					xpl_open;	/*number of open graph files*/
+};
+
+/*A converted packet. The headers are in a buffer of the context and the
+ * payload in the input packet, both valid until the next conversion*/
+struct d2t_pkt{
+	struct pcap_pkthdr	h;			/*libpcap header*/
+	const u_char		*data;		/*rebuilt headers*/
+	int					data_len;	/*bytes at data*/
+	const u_char		*tail;		/*payload, in the input packet*/
+	int					tail_len;	/*bytes at tail (data_len + tail_len == h.caplen)*/
+};
+
+extern __thread struct d2t_ctx *d2t;	/*current context*/
+
+/*Library API*/
+struct d2t_ctx *ctx_new();
+void ctx_free(struct d2t_ctx *ctx);
+int ctx_convert(struct d2t_ctx *ctx, const struct pcap_pkthdr *h, const u_char *bytes,
+		struct d2t_pkt *out);
+int ctx_convert_batch(struct d2t_ctx *ctx, int n, const struct pcap_pkthdr **h,
+		const u_char **bytes, struct d2t_pkt *out);
+void ctx_flush(struct d2t_ctx *ctx);
+int ctx_finish(struct d2t_ctx *ctx);
+void dump_packet(pcap_dumper_t *d, const struct d2t_pkt *pkt);
 
 /*debug printf
  * Levels:
  * 	0) Always print even if debug isn't specified
  *  1) Errors and warnings... Don't overload the screen with too much output
  *  2) Notes and per-packet processing info... as verbose as needed
+ *
+ * This is a macro so that a disabled level costs one branch and the
+ * arguments aren't evaluated. Levels above DBG_MAX_LEVEL are removed at
+ * compile time (make DBG_MAX_LEVEL=1 for production builds).
+ */
+#ifndef DBG_MAX_LEVEL
+#define DBG_MAX_LEVEL	2
+#endif
+#define dbgprintf(level, ...) \
+	do{ \
+		if((level) <= DBG_MAX_LEVEL && __builtin_expect(d2t->debug >= (level), 0)){ \
+			dbgprint(__VA_ARGS__); \
+		} \
+	}while(0)
+void dbgprint(const char *fmt, ...);
+
+/*Warning printf
+ * Counts the warning (globally and for hcn, which may be NULL) and prints
+ * only the first WARN_SAMPLES of each class. warn_summary() reports the rest.
+ */
+#define warnprintf(hcn, w, ...) \
+	do{ \
+		if(warn_count((hcn), (w))){ \
+			dbgprint(__VA_ARGS__); \
+		} \
+	}while(0)
+int warn_count(struct hcon *hcn, enum warn_class w);
+void warn_summary();
+
+/*Profiling
+ * PROF_ENTER switches to a stage and returns the stage to go back to with
+ * PROF_LEAVE. Without --profile both are a single branch.
  */
-void dbgprintf(int level, const char *fmt, ...);
+#define PROF_ENTER(s)	(__builtin_expect(d2t->profile, 0) ? prof_enter(s) : PROF_READ)
+#define PROF_LEAVE(p) \
+	do{ \
+		if(__builtin_expect(d2t->profile, 0)){ \
+			prof_leave(p); \
+		} \
+	}while(0)
+void prof_start();
+enum prof_stage prof_enter(enum prof_stage s);
+void prof_leave(enum prof_stage prev);
+void prof_finish();
+void prof_report();
+
+/*Packet handling functions*/
+void handle_packet(u_char *user, const struct pcap_pkthdr *h, const u_char *bytes);
+u_char* packet_buffer(int slot, int len);
+
+/*Converting many files on worker threads (batch.c, part of the program, not the library)*/
+int batch_convert(const struct d2t_ctx *opts, int jobs, const char *outdir, char **inputs, int ninputs);
+
+/*Following a growing capture file (follow.c, part of the program)*/
+struct follow;
+pcap_t *follow_open(const char *fname, struct follow **fl);
+void follow_loop(struct follow *fl, struct d2t_ctx *ctx);
 
 /*Function to parse encapsulation*/
 int do_encap(int link, struct packet *new, const struct const_packet *old);
@@ -154,12 +429,48 @@ struct connection *add_connection(u_char *src_id, u_char* dest_id, int id_len,
 		int src_port, int dest_port);
 int update_state(struct hcon* hst, enum con_state st);
 void cleanup_connections();
+void retire_connection(struct connection *con);
+void close_connection(struct connection *con);
+void print_alloc_stats();
+char* print_host(char* buf, int len, struct hcon *hcn);
+const char* host_name(struct hcon *hcn);
 
 /*Half Connection/Sequence number functions*/
 u_int32_t initialize_hcon(struct hcon *hcn, d_seq_num initial);
 u_int32_t add_new_seq(struct hcon *hcn, d_seq_num num, int size, enum dccp_pkt_type type);
+int lookup_seq(struct hcon *hcn, d_seq_num num);
 u_int32_t convert_ack(struct hcon *hcn, d_seq_num num, struct hcon *o_hcn);
 int acked_packet_size(struct hcon *hcn, d_seq_num num);
-unsigned int interp_ack_vect(u_char* hdr);
+
+/*Ack Vector functions*/
+struct ack_vect* read_ack_vect(const u_char* hdr, struct hcon *hcn);
+void decode_ack_vect(const u_char* hdr, struct hcon *hcn, struct ack_vect *av);
+unsigned int interp_ack_vect(u_char* hdr, struct hcon *hcn);
+unsigned int ack_vect_losses(u_char* hdr, struct hcon *hcn);
+void ack_vect2sack(struct hcon *hcn, struct tcphdr *tcph,
+		u_char* tcpopts, const struct ack_vect *av, d_seq_num dccpack, struct hcon* o_hcn);
+
+/*Statistics functions*/
+void stats_packet(const struct const_packet *pkt, struct hcon *h1, struct hcon *h2);
+void stats_print(FILE *f, FILE *gf, enum stats_fmt fmt);
+char *stats_goodput_name(const char *file);
+void stats_free(struct hcon *hcn);
+
+/*Time sequence graph functions*/
+void xplot_packet(const struct packet *new, struct hcon *h1, struct hcon *h2);
+void xplot_finish();
+void xplot_flush();
+
+/*Connection selection functions*/
+int filter_select(struct filter *f, const char *arg);
+int filter_count(struct d2t_ctx *ctx, const char *fname);
+void filter_connection(struct connection *con);
+int filter_ccid(struct hcon *h1, struct hcon *h2);
+void filter_packet(const struct const_packet *pkt, struct hcon *h1);
+
+/*Columnar export functions*/
+int columns_open(const char *fname);
+void columns_packet(const struct packet *new, const struct const_packet *old, struct hcon *h1);
+void columns_finish();
 
 #endif
@@ -57,9 +57,11 @@ int do_encap(int link, struct packet *new, const struct const_packet *old)
 				return 0;
 	}
 
-	/*Adjust libpcap header*/
-	if(new->h->caplen >= new->h->len || new->h->caplen >= new->length){
-		new->h->caplen=new->length;
+	/*Adjust libpcap header. The captured part of the tail is written after data
+	 * unless we only want headers*/
+	new->h->caplen=new->length - new->tail_len;
+	if(!d2t->headers_only){
+		new->h->caplen+=new->tail_cap;
 	}
 	new->h->len=new->length;
 
@@ -93,6 +95,7 @@ int ethernet_encap(struct packet *new, const struct const_packet *old)
 		nold.data= old->data+ sizeof(struct ether_header);
 		nnew.data= new->data + sizeof(struct ether_header);
 		nold.length= old->length - sizeof(struct ether_header);
+		nold.tail_len= old->tail_len;
 		nnew.length= new->length - sizeof(struct ether_header);
 		nnew.h=new->h;
 		nold.h=old->h;
@@ -100,6 +103,9 @@ int ethernet_encap(struct packet *new, const struct const_packet *old)
 		nnew.dest_id=NULL;
 		nnew.src_id=NULL;
 		nnew.id_len=0;
+		nnew.tail_len=0;
+		nnew.tail=NULL;
+		nnew.tail_cap=0;
 		nold.print_id=NULL;
 		nold.dest_id=NULL;
 		nold.src_id=NULL;
@@ -123,13 +129,16 @@ int ethernet_encap(struct packet *new, const struct const_packet *old)
 					}
 					break;
 			default:
-					dbgprintf(1, "Unknown Next Protocol at Ethernet\n");
+					warnprintf(NULL, WARN_PROTOCOL, "Unknown Next Protocol at Ethernet\n");
 					return 0;
 					break;
 		}
 
 		/*Adjust length*/
 		new->length=nnew.length + sizeof(struct ether_header);
+		new->tail_len=nnew.tail_len;
+		new->tail=nnew.tail;
+		new->tail_cap=nnew.tail_cap;
 return 1;
 }
 
@@ -160,6 +169,7 @@ int ethernet_vlan_encap(struct packet *new, const struct const_packet *old)
 		nold.data= old->data+ sizeof(struct vlan_tag);
 		nnew.data= new->data + sizeof(struct vlan_tag);
 		nold.length= old->length - sizeof(struct vlan_tag);
+		nold.tail_len= old->tail_len;
 		nnew.length= new->length - sizeof(struct vlan_tag);
 		nnew.h=new->h;
 		nold.h=old->h;
@@ -167,6 +177,9 @@ int ethernet_vlan_encap(struct packet *new, const struct const_packet *old)
 		nnew.dest_id=NULL;
 		nnew.src_id=NULL;
 		nnew.id_len=0;
+		nnew.tail_len=0;
+		nnew.tail=NULL;
+		nnew.tail_cap=0;
 		nold.print_id=NULL;
 		nold.dest_id=NULL;
 		nold.src_id=NULL;
@@ -190,13 +203,16 @@ int ethernet_vlan_encap(struct packet *new, const struct const_packet *old)
 					}
 					break;
 			default:
-					dbgprintf(1, "Unknown Next Protocol at Ethernet VLAN tag\n");
+					warnprintf(NULL, WARN_PROTOCOL, "Unknown Next Protocol at Ethernet VLAN tag\n");
 					return 0;
 					break;
 		}
 
 		/*Adjust length*/
 		new->length=nnew.length + sizeof(struct vlan_tag);
+		new->tail_len=nnew.tail_len;
+		new->tail=nnew.tail;
+		new->tail_cap=nnew.tail_cap;
 return 1;
 }
 
@@ -233,14 +249,29 @@ int ipv6_encap(struct packet *new, const struct const_packet *old)
 		nnew.print_id=print_ipv6;
 		nold.print_id=print_ipv6;
 		nnew.id_len=16;
+		nnew.tail_len=0;
+		nnew.tail=NULL;
+		nnew.tail_cap=0;
 		nold.id_len=16;
 
 		/*Confirm that this is IPv6*/
-		if((ntohl(iph->ip6_ctlun.ip6_un1.ip6_un1_flow) & (0xF0000000)) == (60000000)){
-			dbgprintf(1, "Note: Packet is not IPv6\n");
+		if((ntohl(iph->ip6_ctlun.ip6_un1.ip6_un1_flow) & (0xF0000000)) != 0x60000000){
+			warnprintf(NULL, WARN_PROTOCOL, "Note: Packet is not IPv6\n");
 			return 0;
 		}
 
+		/*Use the payload length. It excludes link layer padding and includes
+		 * anything the capture truncated (0 means a jumbogram)*/
+		nold.tail_len=old->tail_len;
+		if(ntohs(iph->ip6_ctlun.ip6_un1.ip6_un1_plen) > 0){
+			if(ntohs(iph->ip6_ctlun.ip6_un1.ip6_un1_plen) <= nold.length){
+				nold.length=ntohs(iph->ip6_ctlun.ip6_un1.ip6_un1_plen);
+				nold.tail_len=0;
+			}else{
+				nold.tail_len=ntohs(iph->ip6_ctlun.ip6_un1.ip6_un1_plen) - nold.length;
+			}
+		}
+
 		/*Select Next Protocol*/
 		switch(iph->ip6_ctlun.ip6_un1.ip6_un1_nxt){
 			case 33:
@@ -263,7 +294,7 @@ int ipv6_encap(struct packet *new, const struct const_packet *old)
 					}
 					break;
 			default:
-					dbgprintf(1, "Unknown Next Protocol at IPv6\n");
+					warnprintf(NULL, WARN_PROTOCOL, "Unknown Next Protocol at IPv6\n");
 					return 0;
 					break;
 		}
@@ -271,17 +302,20 @@ int ipv6_encap(struct packet *new, const struct const_packet *old)
 		/*set ip to indicate that TCP is next protocol*/
 		iph->ip6_ctlun.ip6_un1.ip6_un1_nxt=6;
 
-		/*Determine if computed length is reasonable*/
+		/*Adjust IPv6 header to account for packet's total length. GSO
+		 * super-segments too large for the field get 0, like the capture*/
 		if(nnew.length > 0xFFFF){
-				dbgprintf(1, "Error: Given TCP data length is too large for an IPv6 packet!\n");
-				return 0;
+			dbgprintf(2, "Note: TCP data length is too large for an IPv6 packet, using 0\n");
+			iph->ip6_ctlun.ip6_un1.ip6_un1_plen=0;
+		}else{
+			iph->ip6_ctlun.ip6_un1.ip6_un1_plen=htons(nnew.length);
 		}
 
-		/*Adjust IPv6 header to account for packet's total length*/
-		iph->ip6_ctlun.ip6_un1.ip6_un1_plen=htons(nnew.length);
-
 		/*Adjust length*/
 		new->length=nnew.length + sizeof(struct ip6_hdr);
+		new->tail_len=nnew.tail_len;
+		new->tail=nnew.tail;
+		new->tail_cap=nnew.tail_cap;
 
 		/*Cleanup*/
 		free(nnew.dest_id);
@@ -324,14 +358,29 @@ int ipv4_encap(struct packet *new, const struct const_packet *old)
 		nnew.print_id=print_ipv4;
 		nold.print_id=print_ipv4;
 		nnew.id_len=4;
+		nnew.tail_len=0;
+		nnew.tail=NULL;
+		nnew.tail_cap=0;
 		nold.id_len=4;
 
 		/*Confirm that this is IPv4*/
 		if(iph->version!=4){
-			dbgprintf(1, "Note: Packet is not IPv4\n");
+			warnprintf(NULL, WARN_PROTOCOL, "Note: Packet is not IPv4\n");
 			return 0;
 		}
 
+		/*Use the total length. It excludes link layer padding and includes
+		 * anything the capture truncated (0 means segmentation offload)*/
+		nold.tail_len=old->tail_len;
+		if(ntohs(iph->tot_len) >= iph->ihl*4){
+			if(ntohs(iph->tot_len) - iph->ihl*4 <= nold.length){
+				nold.length=ntohs(iph->tot_len) - iph->ihl*4;
+				nold.tail_len=0;
+			}else{
+				nold.tail_len=ntohs(iph->tot_len) - iph->ihl*4 - nold.length;
+			}
+		}
+
 		/*Select Next Protocol*/
 		switch(iph->protocol){
 			case 33:
@@ -354,7 +403,7 @@ int ipv4_encap(struct packet *new, const struct const_packet *old)
 					}
 					break;
 			default:
-					dbgprintf(1, "Unknown Next Protocol at IPv4\n");
+					warnprintf(NULL, WARN_PROTOCOL, "Unknown Next Protocol at IPv4\n");
 					return 0;
 					break;
 		}
@@ -365,16 +414,19 @@ int ipv4_encap(struct packet *new, const struct const_packet *old)
 
 		/*Adjust length*/
 		new->length=nnew.length + iph->ihl*4;
-
-		/*Determine if computed length is reasonable*/
-		if(nnew.length > 0xFFFF){
-				dbgprintf(1, "Error: Given TCP header+data length is too large for an IPv4 packet!\n");
-				return 0;
+		new->tail_len=nnew.tail_len;
+		new->tail=nnew.tail;
+		new->tail_cap=nnew.tail_cap;
+
+		/*Adjust IPv4 header to account for packet's total length. GSO/TSO
+		 * super-segments too large for the field get 0, like the capture*/
+		if(new->length > 0xFFFF){
+			dbgprintf(2, "Note: TCP header+data length is too large for an IPv4 packet, using 0\n");
+			iph->tot_len=0;
+		}else{
+			iph->tot_len=htons(new->length);
 		}
 
-		/*Adjust IPv4 header to account for packet's total length*/
-		iph->tot_len=htons(new->length);
-
 		/*Compute IPv4 Checksum*/
 		iph->check=0;
 		iph->check=ipv4_chksum(new->data,iph->ihl*4);
@@ -414,6 +466,7 @@ int linux_cooked_encap(struct packet *new, const struct const_packet *old)
 	nold.data= old->data + sizeof(struct sll_header);
 	nnew.data= new->data + sizeof(struct sll_header);
 	nold.length= old->length - sizeof(struct sll_header);
+	nold.tail_len= old->tail_len;
 	nnew.length= new->length- sizeof(struct sll_header);
 	nnew.h=new->h;
 	nold.h=old->h;
@@ -421,6 +474,9 @@ int linux_cooked_encap(struct packet *new, const struct const_packet *old)
 	nnew.dest_id=NULL;
 	nnew.src_id=NULL;
 	nnew.id_len=0;
+	nnew.tail_len=0;
+	nnew.tail=NULL;
+	nnew.tail_cap=0;
 	nold.print_id=NULL;
 	nold.dest_id=NULL;
 	nold.src_id=NULL;
@@ -428,7 +484,7 @@ int linux_cooked_encap(struct packet *new, const struct const_packet *old)
 
 	/*Confirm that this is SLL*/
 	if(ntohs(slh->sll_pkttype) > 4){
-		dbgprintf(1, "Note: Packet is not SLL (Linux Cooked Capture)\n");
+		warnprintf(NULL, WARN_PROTOCOL, "Note: Packet is not SLL (Linux Cooked Capture)\n");
 		return 0;
 	}
 
@@ -445,13 +501,16 @@ int linux_cooked_encap(struct packet *new, const struct const_packet *old)
 				}
 				break;
 		default:
-				dbgprintf(1, "Unknown Next Protocol at SLL\n");
+				warnprintf(NULL, WARN_PROTOCOL, "Unknown Next Protocol at SLL\n");
 				return 0;
 				break;
 	}
 
 	/*Adjust length*/
 	new->length=nnew.length + sizeof(struct sll_header);
+	new->tail_len=nnew.tail_len;
+	new->tail=nnew.tail;
+	new->tail_cap=nnew.tail_cap;
 return 1;
 }
 
@@ -464,6 +523,7 @@ char *print_ipv6(char* buf, int len, u_char* id, int id_len)
 		return NULL;
 	}
 
+	memset(&sa,0,sizeof(struct sockaddr_in6));
 	memcpy(&sa.sin6_addr, id, id_len);
 	sa.sin6_family=AF_INET6;
 	if(getnameinfo((struct sockaddr*)&sa, sizeof(struct sockaddr_in6),
@@ -481,6 +541,7 @@ char *print_ipv4(char* buf, int len, u_char* id, int id_len)
 		return NULL;
 	}
 
+	memset(&sa,0,sizeof(struct sockaddr_in));
 	memcpy(&sa.sin_addr, id, id_len);
 	sa.sin_family=AF_INET;
 	if(getnameinfo((struct sockaddr*)&sa, sizeof(struct sockaddr_in),
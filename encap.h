@@ -56,6 +56,16 @@ Date: 11/2012
  *  						This is a function to pretty-print the destination or
  *  						source ID to the given buffer.
  *
+ *  	int tail_len:		Bytes at the end of the new packet that are not stored
+ *  						in data (payload that is not copied). These ARE
+ *  						included in length. Each encapsulation must pass
+ *  						this (and tail, tail_cap) back up from the layer below.
+ *
+ *  	const u_char *tail:	Location of those bytes in the old packet.
+ *
+ *  	int tail_cap:		How many of the tail_len bytes at tail were captured.
+ *  						The rest weren't, so the checksum can't be computed.
+ *
  *	struct const_packet *old:	The Old packet. It contains the following fields.
  *
  *  	u_char* data:		This is a pointer to the buffer containing the
@@ -66,6 +76,10 @@ Date: 11/2012
  *  						layer MUST decrement this by the amount of it's
  *  						headers. An encapsulation layer MUST never read
  *  						beyond this into old->data.
+ *
+ *  	int tail_len:		Bytes of the old packet, at this layer, that are
+ *  						beyond length because the capture was truncated.
+ *  						Layers with a length field (IP) recompute this.
  */
 
 /*
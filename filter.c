@@ -0,0 +1,258 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Functions for selecting the connections to convert.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	1)A connection that isn't selected is marked IGNORE when it is created,
+		so its packets only cost the connection lookup. No tables, statistics
+		or output are kept for it.
+	2)The CCID is only known after feature negotiation (or the first Ack
+		Vector or NDP Count option), so a connection of another CCID is
+		ignored from then on. Its Request is still converted. Its tables
+		are retired for reuse by later connections.
+	3)Whether a connection is large enough is only known at the end of the
+		capture, so filter_count() reads the capture once beforehand, only
+		counting packets per address/port four-tuple.
+******************************************************************************/
+#include "dccp2tcp.h"
+
+int filter_ep(const char *str, struct filter_ep *ep);
+int filter_match(struct filter_ep *sel, struct connection *con);
+int filter_match_ep(struct filter_ep *ep, struct hcon *hcn);
+
+
+/*Add a selection to f from a --select argument: one or two ends separated
+ * by a comma. Returns 0 if the argument can't be parsed*/
+int filter_select(struct filter *f, const char *arg)
+{
+	struct filter_ep	sel[2];
+	char				buf[2*(INET6_ADDRSTRLEN + 10)];
+	char				*comma;
+
+	if(strlen(arg) >= sizeof(buf)){
+		return 0;
+	}
+	strcpy(buf, arg);
+	comma=strchr(buf, ',');
+	if(comma){
+		*comma=0;
+	}
+	if(!filter_ep(buf, &sel[0]) || !filter_ep(comma ? comma + 1 : "*", &sel[1])){
+		return 0;
+	}
+
+	f->sel=realloc(f->sel, (f->nsel + 1)*sizeof(*f->sel));
+	if(f->sel==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+	memcpy(f->sel[f->nsel], sel, sizeof(sel));
+	f->nsel++;
+return 1;
+}
+
+/*Parse one end: addr, addr:port, [addr]:port (IPv6), :port or *. An empty
+ * or * address or port matches any. Returns 0 if it can't be parsed*/
+int filter_ep(const char *str, struct filter_ep *ep)
+{
+	char	buf[INET6_ADDRSTRLEN + 10];
+	char	*addr=buf;
+	char	*port=NULL;
+	char	*end;
+
+	ep->id_len=0;
+	ep->port=-1;
+	if(strlen(str) >= sizeof(buf)){
+		return 0;
+	}
+	strcpy(buf, str);
+
+	/*split off the port*/
+	if(buf[0]=='['){
+		addr=buf + 1;
+		end=strchr(addr, ']');
+		if(end==NULL || (end[1]!=0 && end[1]!=':')){
+			return 0;
+		}
+		*end=0;
+		if(end[1]==':'){
+			port=end + 2;
+		}
+	}else if(strchr(buf, ':')!=NULL && strchr(buf, ':')==strrchr(buf, ':')){
+		port=strchr(buf, ':');
+		*port++=0;
+	}
+
+	/*address*/
+	if(addr[0]!=0 && strcmp(addr, "*")!=0){
+		if(inet_pton(AF_INET, addr, ep->id)==1){
+			ep->id_len=IP4_ADDR_LEN;
+		}else if(inet_pton(AF_INET6, addr, ep->id)==1){
+			ep->id_len=IP6_ADDR_LEN;
+		}else{
+			return 0;
+		}
+	}
+
+	/*port*/
+	if(port!=NULL && port[0]!=0 && strcmp(port, "*")!=0){
+		ep->port=strtol(port, &end, 10);
+		if(*end!=0 || ep->port < 0 || ep->port > 65535){
+			return 0;
+		}
+	}
+return 1;
+}
+
+/*Count packets and data bytes of every connection of fname that passes the
+ * address/port selection, and keep the ones reaching the minimums of the
+ * filter of ctx. Must be called before converting with such a filter.
+ * Returns 0 if fname can't be read*/
+int filter_count(struct d2t_ctx *ctx, const char *fname)
+{
+	char				ebuf[PCAP_ERRBUF_SIZE];
+	pcap_t				*in;
+	struct d2t_ctx		*cnt;
+	struct connection	*ptr;
+	u_int64_t			pkts;
+	u_int64_t			bytes;
+
+	in=pcap_open_offline(fname, ebuf);
+	if(in==NULL){
+		dbgprintf(0,"Error opening input file %s: %s\n", fname, ebuf);
+		return 0;
+	}
+
+	/*Only get_host() and filter_packet() for each packet*/
+	cnt=ctx_new();
+	cnt->debug=-1;		/*the conversion reports any problems*/
+	cnt->filter=ctx->filter;
+	cnt->counting=1;
+	cnt->link=pcap_datalink(in);
+	pcap_loop(in, -1, handle_packet, (u_char*)cnt);
+	pcap_close(in);
+
+	free(ctx->keep);
+	ctx->keep=NULL;
+	ctx->nkeep=0;
+	for(ptr=cnt->chead; ptr!=NULL; ptr=ptr->next){
+		pkts=ptr->A.stats.pkts + ptr->B.stats.pkts;
+		bytes=ptr->A.stats.bytes + ptr->B.stats.bytes;
+		if(ptr->A.state==IGNORE || pkts < ctx->filter->min_pkts || bytes < ctx->filter->min_bytes){
+			continue;
+		}
+		ctx->keep=realloc(ctx->keep, (ctx->nkeep + 1)*sizeof(*ctx->keep));
+		if(ctx->keep==NULL){
+			dbgprintf(0,"Error: Couldn't allocate Memory\n");
+			exit(1);
+		}
+		ctx->keep[ctx->nkeep][0].id_len=ptr->A.id_len;
+		memcpy(ctx->keep[ctx->nkeep][0].id, ptr->A.id, IP6_ADDR_LEN);
+		ctx->keep[ctx->nkeep][0].port=ntohs(ptr->A.port);
+		ctx->keep[ctx->nkeep][1].id_len=ptr->B.id_len;
+		memcpy(ctx->keep[ctx->nkeep][1].id, ptr->B.id, IP6_ADDR_LEN);
+		ctx->keep[ctx->nkeep][1].port=ntohs(ptr->B.port);
+		ctx->nkeep++;
+	}
+	ctx_free(cnt);
+	d2t=ctx;
+	dbgprintf(1,"%i connections large enough to convert\n", ctx->nkeep);
+return 1;
+}
+
+/*Mark a new connection IGNORE if the filter doesn't select it*/
+void filter_connection(struct connection *con)
+{
+	const struct filter	*f=d2t->filter;
+	int					sel;
+
+	sel= f->nsel==0;
+	for(int i=0; i < f->nsel && !sel; i++){
+		sel=filter_match(f->sel[i], con);
+	}
+	if(sel && !d2t->counting && (f->min_pkts || f->min_bytes)){
+		sel=0;
+		for(int i=0; i < d2t->nkeep && !sel; i++){
+			sel=filter_match(d2t->keep[i], con);
+		}
+	}
+	if(!sel){
+		dbgprintf(2,"Ignoring connection between %s:%i and %s:%i (not selected)\n",
+			host_name(&con->A), ntohs(con->A.port), host_name(&con->B), ntohs(con->B.port));
+		update_state(&con->A, IGNORE);
+		update_state(&con->B, IGNORE);
+	}
+}
+
+/*Check the CCID of a connection once it is known. Returns 0 (and ignores
+ * the connection) if it isn't the one selected*/
+int filter_ccid(struct hcon *h1, struct hcon *h2)
+{
+	enum con_type		ccid=d2t->filter->ccid;
+
+	if(h1->type==ccid || h2->type==ccid){
+		return 1;
+	}
+	if(h1->type!=CCID2 && h1->type!=CCID3 && h2->type!=CCID2 && h2->type!=CCID3){
+		return 1;	/*not known yet*/
+	}
+	dbgprintf(2,"Ignoring connection between %s:%i and %s:%i (CCID)\n",
+		host_name(h1), ntohs(h1->port), host_name(h2), ntohs(h2->port));
+	update_state(h1, IGNORE);
+	update_state(h2, IGNORE);
+	retire_connection(d2t->last_conn);
+return 0;
+}
+
+/*Count a packet sent by h1 (filter_count())*/
+void filter_packet(const struct const_packet *pkt, struct hcon *h1)
+{
+	struct dccp_hdr		*dccph;
+	int					datalength;
+
+	dccph=(struct dccp_hdr*)pkt->data;
+	h1->stats.pkts++;
+	if(dccph->dccph_type==DCCP_PKT_DATA || dccph->dccph_type==DCCP_PKT_DATAACK){
+		datalength=pkt->length + pkt->tail_len - dccph->dccph_doff*4;
+		if(datalength > 0){
+			h1->stats.bytes+=datalength;
+		}
+	}
+}
+
+/*Returns true if the pair of ends sel matches con, in either direction*/
+int filter_match(struct filter_ep *sel, struct connection *con)
+{
+	return (filter_match_ep(&sel[0], &con->A) && filter_match_ep(&sel[1], &con->B)) ||
+			(filter_match_ep(&sel[0], &con->B) && filter_match_ep(&sel[1], &con->A));
+}
+
+/*Returns true if ep matches the address and port of hcn*/
+int filter_match_ep(struct filter_ep *ep, struct hcon *hcn)
+{
+	if(ep->id_len!=0 && (ep->id_len!=hcn->id_len || memcmp(ep->id, hcn->id, ep->id_len)!=0)){
+		return FALSE;
+	}
+	if(ep->port >= 0 && ep->port!=ntohs(hcn->port)){
+		return FALSE;
+	}
+	return TRUE;
+}
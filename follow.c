@@ -0,0 +1,301 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Following a capture file that is still being written.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	1)libpcap stops at the end of a file and treats a record that is only
+		partly written as an error, so the file is read here directly. A
+		partial record is read again once the rest of it is there.
+	2)The file is polled every FOLLOW_POLL_MS. When we have caught up, the
+		outputs are flushed. While catching up they are flushed at least
+		every FOLLOW_FLUSH_MS.
+	3)Rotation: when the name refers to a new file (tcpdump -C/-G, or
+		logrotate), the rest of the old file is converted and the new one
+		is read from the start. A file that gets shorter is read again from
+		the start. Connections carry over, the link type must stay the same.
+	4)SIGINT or SIGTERM ends following and dccp2tcp finishes normally. So
+		does a new file that isn't in pcap format (only pcap is read here,
+		not pcapng: use dumpcap -P or tcpdump -w).
+******************************************************************************/
+#include "dccp2tcp.h"
+#include <signal.h>
+#include <sys/stat.h>
+
+#define FOLLOW_POLL_MS		100		/*Time between looks at the file at its end*/
+#define FOLLOW_FLUSH_MS		200		/*Longest time output is held while catching up*/
+#define TCPDUMP_MAGIC		0xa1b2c3d4	/*Microsecond timestamps*/
+#define NSEC_TCPDUMP_MAGIC	0xa1b23c4d	/*Nanosecond timestamps*/
+
+/*File being followed*/
+struct follow{
+	const char		*fname;		/*File name*/
+	FILE			*f;			/*Open file*/
+	dev_t			dev;		/*Device of the open file*/
+	ino_t			ino;		/*Inode of the open file*/
+	off_t			pos;		/*Offset of the next record*/
+	int				swap;		/*File is in the other byte order*/
+	int				nsec;		/*Timestamps are in nanoseconds*/
+	int				link;		/*Link type*/
+	int				snap;		/*Snapshot length*/
+	u_char			*buf;		/*Record data*/
+	u_int32_t		buf_len;	/*Size of buf*/
+};
+
+static volatile sig_atomic_t	follow_stop=0;	/*Set by SIGINT/SIGTERM*/
+
+int follow_open_file(struct follow *fl);
+int follow_next(struct follow *fl, struct pcap_pkthdr *h, const u_char **data);
+void follow_rewind(struct follow *fl);
+int follow_rotated(struct follow *fl);
+void follow_sleep(int ms);
+double follow_now();
+void follow_signal(int sig);
+
+
+/*Start following fname, waiting for it to exist. Returns a libpcap handle
+ * with the link type and snapshot length of the capture (for opening the
+ * output) and the follow state in fl*/
+pcap_t *follow_open(const char *fname, struct follow **fl)
+{
+	struct follow *n;
+	int ret;
+
+	n=calloc(1, sizeof(struct follow));
+	if(n==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+	n->fname=fname;
+
+	signal(SIGINT, follow_signal);
+	signal(SIGTERM, follow_signal);
+	while((ret=follow_open_file(n))==0){
+		if(follow_stop){
+			exit(1);
+		}
+		follow_sleep(FOLLOW_POLL_MS);
+	}
+	if(ret < 0){
+		free(n);
+		return NULL;
+	}
+	*fl=n;
+return pcap_open_dead(n->link, n->snap);
+}
+
+/*Convert records as they are written until a signal. ctx is the context
+ * to convert in, with its outputs open*/
+void follow_loop(struct follow *fl, struct d2t_ctx *ctx)
+{
+	struct pcap_pkthdr	h;
+	const u_char		*data;
+	double				flushed;
+	int					ret;
+	int					fresh=0;
+
+	flushed=follow_now();
+	while(!follow_stop){
+		/*Convert what is there*/
+		while((ret=follow_next(fl, &h, &data))==1){
+			handle_packet((u_char*)ctx, &h, data);
+			fresh=1;
+			if(follow_now() - flushed >= FOLLOW_FLUSH_MS/1000.0){
+				ctx_flush(ctx);
+				flushed=follow_now();
+				fresh=0;
+			}
+			if(follow_stop){
+				break;
+			}
+		}
+		if(ret < 0){
+			break;
+		}
+
+		/*Caught up*/
+		if(fresh){
+			ctx_flush(ctx);
+			flushed=follow_now();
+			fresh=0;
+		}
+		if((ret=follow_rotated(fl))){
+			/*Records written just before the switch*/
+			while(ret==1 && follow_next(fl, &h, &data)==1){
+				handle_packet((u_char*)ctx, &h, data);
+			}
+			ctx_flush(ctx);
+			fclose(fl->f);
+			fl->f=NULL;
+			while(!follow_stop && follow_open_file(fl)==0){
+				follow_sleep(FOLLOW_POLL_MS);
+			}
+			if(fl->f==NULL){
+				break;		/*interrupted, or not a pcap file*/
+			}
+			if(fl->link!=ctx->link){
+				dbgprintf(0,"Error: Link type of %s changed\n", fl->fname);
+				break;
+			}
+			dbgprintf(1,"Following new file %s\n", fl->fname);
+			continue;
+		}
+		follow_sleep(FOLLOW_POLL_MS);
+	}
+
+	if(fl->f){
+		fclose(fl->f);
+	}
+	free(fl->buf);
+	free(fl);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+}
+
+/*Open the file and read its header. Returns 0 if it isn't there or the
+ * header isn't complete yet, -1 if it isn't a pcap file*/
+int follow_open_file(struct follow *fl)
+{
+	struct stat		st;
+	u_int32_t		hdr[6];		/*magic, version, zone, sigfigs, snaplen, link*/
+
+	fl->f=fopen(fl->fname, "rb");
+	if(fl->f==NULL){
+		return 0;
+	}
+	if(fstat(fileno(fl->f), &st)!=0 || fread(hdr, sizeof(hdr), 1, fl->f)!=1){
+		fclose(fl->f);
+		fl->f=NULL;
+		return 0;
+	}
+
+	fl->swap=0;
+	fl->nsec=0;
+	if(hdr[0]==TCPDUMP_MAGIC || hdr[0]==NSEC_TCPDUMP_MAGIC){
+		fl->nsec= hdr[0]==NSEC_TCPDUMP_MAGIC;
+	}else if(hdr[0]==__builtin_bswap32(TCPDUMP_MAGIC) || hdr[0]==__builtin_bswap32(NSEC_TCPDUMP_MAGIC)){
+		fl->swap=1;
+		fl->nsec= hdr[0]==__builtin_bswap32(NSEC_TCPDUMP_MAGIC);
+	}else{
+		dbgprintf(0,"Error: %s is not a pcap file (pcapng can't be followed)\n", fl->fname);
+		fclose(fl->f);
+		fl->f=NULL;
+		return -1;
+	}
+	fl->snap= fl->swap ? __builtin_bswap32(hdr[4]) : hdr[4];
+	fl->link= (fl->swap ? __builtin_bswap32(hdr[5]) : hdr[5]) & 0x0FFFFFFF;
+	fl->dev=st.st_dev;
+	fl->ino=st.st_ino;
+	fl->pos=sizeof(hdr);
+return 1;
+}
+
+/*Read the next record. Returns 1 with the record in h and data, 0 if it
+ * isn't completely written yet, -1 on a corrupt file*/
+int follow_next(struct follow *fl, struct pcap_pkthdr *h, const u_char **data)
+{
+	u_int32_t	rec[4];		/*sec, usec (or nsec), caplen, len*/
+	u_char		*tmp;
+
+	if(fread(rec, sizeof(rec), 1, fl->f)!=1){
+		follow_rewind(fl);
+		return 0;
+	}
+	if(fl->swap){
+		for(int i=0; i < 4; i++){
+			rec[i]=__builtin_bswap32(rec[i]);
+		}
+	}
+	if(rec[2] > rec[3] || rec[2] > 0x4000000){
+		dbgprintf(0,"Error: Corrupt record in %s\n", fl->fname);
+		return -1;
+	}
+	if(rec[2] > fl->buf_len){
+		tmp=realloc(fl->buf, rec[2]);
+		if(tmp==NULL){
+			dbgprintf(0,"Error: Couldn't allocate Memory\n");
+			exit(1);
+		}
+		fl->buf=tmp;
+		fl->buf_len=rec[2];
+	}
+	if(rec[2] > 0 && fread(fl->buf, rec[2], 1, fl->f)!=1){
+		follow_rewind(fl);
+		return 0;
+	}
+
+	h->ts.tv_sec=(int32_t)rec[0];
+	h->ts.tv_usec= fl->nsec ? rec[1]/1000 : rec[1];
+	h->caplen=rec[2];
+	h->len=rec[3];
+	*data=fl->buf;
+	fl->pos+=sizeof(rec) + rec[2];
+return 1;
+}
+
+/*Go back to the start of a partly written record, to read it again later*/
+void follow_rewind(struct follow *fl)
+{
+	clearerr(fl->f);
+	fseeko(fl->f, fl->pos, SEEK_SET);
+}
+
+/*Returns 1 if the name now refers to another file, 2 if the file was
+ * truncated. Either way the open file won't be written anymore*/
+int follow_rotated(struct follow *fl)
+{
+	struct stat		st;
+
+	if(stat(fl->fname, &st)!=0){
+		return 0;	/*gone for the moment, the new one isn't there yet*/
+	}
+	if(st.st_dev!=fl->dev || st.st_ino!=fl->ino){
+		return 1;
+	}
+	if(st.st_size < fl->pos){
+		return 2;
+	}
+return 0;
+}
+
+/*Sleep for ms milliseconds*/
+void follow_sleep(int ms)
+{
+	struct timespec ts;
+
+	ts.tv_sec=ms/1000;
+	ts.tv_nsec=(ms%1000)*1000000;
+	nanosleep(&ts, NULL);
+}
+
+/*Monotonic wall clock in seconds*/
+double follow_now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/*Signal handler: stop following*/
+void follow_signal(int sig)
+{
+	follow_stop=1;
+}
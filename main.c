@@ -0,0 +1,389 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Command line handling.
+
+Copyright (C) 2013  Samuel Jero <sj323707@ohio.edu>
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: Samuel Jero <sj323707@ohio.edu>
+Date: 02/2013
+Contributors: dccp2tcp contributors, 10/2026 (moved out of dccp2tcp.c)
+
+Notes:
+	1)Only main() and its helpers live here. Everything else is
+		libdccp2tcp, which other programs (like bench/microbench) link.
+******************************************************************************/
+#include "dccp2tcp.h"
+#include <sys/stat.h>
+#include <errno.h>
+
+
+#define DCCP2TCP_VERSION 1.6
+#define COPYRIGHT_YEAR 2013
+
+
+void version();
+void usage();
+
+
+/*Parse commandline options and open files*/
+int main(int argc, char *argv[])
+{
+	char ebuf[200];
+	char *erbuffer=ebuf;
+	char *dfile=NULL;
+	char *tfile=NULL;
+	FILE *sfile=NULL;
+	FILE *gfile=NULL;
+	char *gname;
+	pcap_t *in;
+	struct d2t_ctx *ctx;
+	char **inputs;
+	int ninputs=0;
+	int extra=0;
+	char *outdir=NULL;
+	int jobs=0;
+	int ret;
+	int follow=0;
+	struct follow *fl=NULL;
+	struct filter filter;
+
+	ctx=ctx_new();
+	memset(&filter, 0, sizeof(struct filter));
+	inputs=malloc(argc*sizeof(char*));
+	if(inputs==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+
+	/*loop through commandline options*/
+	for(int i=1; i < argc; i++){
+		if(argv[i][0]!='-' || (argv[i][0]=='-' && strlen(argv[i])==1)){
+			inputs[ninputs++]=argv[i];
+			if(dfile==NULL){
+				/*assign first non-dash (or only dash) argument to the dccp file*/
+				dfile=argv[i];
+			}else{
+				if(tfile==NULL){
+					tfile=argv[i]; /*assign second non-dash (or only dash) argument to the tcp file*/
+				}else{
+					extra=1; /*only valid with --outdir*/
+				}
+			}
+		}else{
+			if(strcmp(argv[i],"--stats")==0 || strcmp(argv[i],"--stats=csv")==0){ /* --stats */
+				ctx->stats=STATS_CSV;
+			}else if(strcmp(argv[i],"--stats=json")==0){ /* --stats=json */
+				ctx->stats=STATS_JSON;
+			}else if(strcmp(argv[i],"--xplot")==0){ /* --xplot */
+				ctx->xplot="";
+			}else if(strncmp(argv[i],"--xplot=",8)==0){ /* --xplot=prefix */
+				ctx->xplot=argv[i]+8;
+			}else if(strncmp(argv[i],"--xplot-points=",15)==0){ /* --xplot-points=N */
+				ctx->xplot_points=atoi(argv[i]+15);
+				if(ctx->xplot_points <= 0){
+					usage();
+				}
+			}else if(strncmp(argv[i],"--columns=",10)==0){ /* --columns=file */
+				ctx->columns=argv[i]+10;
+			}else if(strcmp(argv[i],"--no-pcap")==0){ /* --no-pcap */
+				ctx->nopcap=1;
+			}else if(strcmp(argv[i],"--headers-only")==0){ /* --headers-only */
+				ctx->headers_only=1;
+			}else if(strcmp(argv[i],"--profile")==0){ /* --profile */
+				ctx->profile=1;
+			}else if(strncmp(argv[i],"--flush-packets=",16)==0){ /* --flush-packets=N */
+				ctx->flush_packets=atoi(argv[i]+16);
+				if(ctx->flush_packets <= 0){
+					usage();
+				}
+			}else if(strncmp(argv[i],"--flush-ms=",11)==0){ /* --flush-ms=M */
+				ctx->flush_ms=atoi(argv[i]+11);
+				if(ctx->flush_ms <= 0){
+					usage();
+				}
+			}else if(strncmp(argv[i],"--select=",9)==0){ /* --select=end[,end] */
+				if(!filter_select(&filter, argv[i]+9)){
+					dbgprintf(0,"Error: Can't parse %s\n", argv[i]);
+					usage();
+				}
+			}else if(strcmp(argv[i],"--ccid=2")==0){ /* --ccid=2 */
+				filter.ccid=CCID2;
+			}else if(strcmp(argv[i],"--ccid=3")==0){ /* --ccid=3 */
+				filter.ccid=CCID3;
+			}else if(strncmp(argv[i],"--min-packets=",14)==0){ /* --min-packets=N */
+				filter.min_pkts=strtoull(argv[i]+14, NULL, 10);
+				if(filter.min_pkts==0){
+					usage();
+				}
+			}else if(strncmp(argv[i],"--min-bytes=",12)==0){ /* --min-bytes=N */
+				filter.min_bytes=strtoull(argv[i]+12, NULL, 10);
+				if(filter.min_bytes==0){
+					usage();
+				}
+			}else if(strcmp(argv[i],"--follow")==0){ /* --follow */
+				follow=1;
+			}else if(strncmp(argv[i],"--outdir=",9)==0){ /* --outdir=dir */
+				outdir=argv[i]+9;
+			}else if(argv[i][1]=='j' && strlen(argv[i])==2){ /* -j N */
+				if(i+1 >= argc || (jobs=atoi(argv[++i])) <= 0){
+					usage();
+				}
+			}else if(argv[i][1]=='v' && strlen(argv[i])==2){ /* -v */
+				ctx->debug++;
+			}else if(argv[i][1]=='y' && strlen(argv[i])==2){ /* -y */
+				ctx->yellow=1;
+			}else if(argv[i][1]=='g' && strlen(argv[i])==2){ /* -g */
+				ctx->green=1;
+			}else if(argv[i][1]=='s' && strlen(argv[i])==2){ /* -s */
+				ctx->sack++;
+			}else if(argv[i][1]=='h' && strlen(argv[i])==2){ /* -h */
+				usage();
+			}else if(argv[i][1]=='V' && strlen(argv[i])==2){ /* -V */
+				version();
+			}else{
+				usage();
+			}
+		}
+	}
+	
+	if(ctx->stats){
+		ctx->nopcap=0;
+	}
+	if(filter.nsel || filter.ccid!=UNKNOWN || filter.min_pkts || filter.min_bytes){
+		ctx->filter=&filter;
+	}
+
+	/*Many files into a directory*/
+	if(outdir){
+		if(ninputs==0 || ctx->profile || follow){
+			usage();
+		}
+		if(jobs==0){
+			jobs=sysconf(_SC_NPROCESSORS_ONLN);
+			jobs= jobs > 0 ? jobs : 1;
+		}
+		if(mkdir(outdir, 0777)!=0 && errno!=EEXIST){
+			dbgprintf(0,"Error creating output directory %s\n", outdir);
+			exit(1);
+		}
+		ret=batch_convert(ctx, jobs, outdir, inputs, ninputs);
+		ctx_free(ctx);
+		free(inputs);
+		free(filter.sel);
+		return ret ? 1 : 0;
+	}
+	free(inputs);
+
+	if(dfile==NULL || extra || jobs || ((follow || filter.min_pkts || filter.min_bytes) && strcmp(dfile,"-")==0) ||
+			(follow && (filter.min_pkts || filter.min_bytes)) || (tfile==NULL && !ctx->nopcap) || (tfile!=NULL && ctx->nopcap)){
+		usage();
+	}
+
+	/*all options validated*/
+
+	if(ctx->debug){
+		if(ctx->green){
+			dbgprintf(1,"Tcptrace green line at highest acknowledgment\n");
+		}else{
+			dbgprintf(1,"Tcptrace green line at highest acknowledged acknowledgment\n");
+		}
+		if(ctx->yellow){
+			dbgprintf(1,"Tcptrace yellow line at highest acknowledgment\n");
+		}else{
+			dbgprintf(1,"Tcptrace yellow line window value (a made up number)\n");
+		}
+		if(ctx->sack){
+			dbgprintf(1,"Adding TCP SACKS\n");
+		}
+		if(ctx->stats){
+			dbgprintf(1,"Writing statistics instead of a TCP capture\n");
+		}
+		if(ctx->xplot){
+			dbgprintf(1,"Writing time sequence graphs\n");
+		}
+		if(ctx->columns){
+			dbgprintf(1,"Columns file: %s\n", ctx->columns);
+		}
+		if(ctx->headers_only){
+			dbgprintf(1,"Writing headers only\n");
+		}
+		if(ctx->flush_packets){
+			dbgprintf(1,"Flushing output every %i packets\n", ctx->flush_packets);
+		}
+		if(ctx->flush_ms){
+			dbgprintf(1,"Flushing output every %i ms of capture time\n", ctx->flush_ms);
+		}
+		if(ctx->filter){
+			dbgprintf(1,"Converting selected connections only\n");
+		}
+		if(follow){
+			dbgprintf(1,"Following input file until interrupted\n");
+		}
+		dbgprintf(1,"Input file: %s\n", dfile);
+		if(tfile){
+			dbgprintf(1,"Output file: %s\n", tfile);
+		}
+	}
+
+	/*find the connections large enough to convert*/
+	if(filter.min_pkts || filter.min_bytes){
+		if(!filter_count(ctx, dfile)){
+			exit(1);
+		}
+	}
+
+	/*attempt to open input file (waiting for it with --follow)*/
+	if(follow){
+		in=follow_open(dfile, &fl);
+	}else{
+		in=pcap_open_offline(dfile, erbuffer);
+	}
+	if(in==NULL){
+		dbgprintf(0,"Error opening input file\n");
+		exit(1);
+	}
+
+	ctx->link=pcap_datalink(in);
+
+	/*attempt to open output file*/
+	if(ctx->stats){
+		sfile= strcmp(tfile,"-")==0 ? stdout : fopen(tfile,"w");
+		if(sfile==NULL){
+			dbgprintf(0,"Error opening output file\n");
+			exit(1);
+		}
+		/*the CSV goodput time series is a second table, in its own file*/
+		if(ctx->stats==STATS_CSV && sfile!=stdout){
+			gname=stats_goodput_name(tfile);
+			if(gname==NULL){
+				exit(1);
+			}
+			gfile=fopen(gname,"w");
+			if(gfile==NULL){
+				dbgprintf(0,"Error opening output file %s\n", gname);
+				exit(1);
+			}
+			dbgprintf(1,"Goodput file: %s\n", gname);
+			free(gname);
+		}
+	}else if(!ctx->nopcap && strcmp(tfile,"-")==0){
+		/*stream to a pipe: large writes, flushed as --flush-* ask*/
+		setvbuf(stdout, NULL, _IOFBF, OUT_BUF_SZ);
+		ctx->out=pcap_dump_fopen(in,stdout);
+		if(ctx->out==NULL){
+			dbgprintf(0,"Error opening output file\n");
+			exit(1);
+		}
+	}else if(!ctx->nopcap){
+		ctx->out=pcap_dump_open(in,tfile);
+		if(ctx->out==NULL){
+			dbgprintf(0,"Error opening output file\n");
+			exit(1);
+		}
+	}
+	if(ctx->columns && !columns_open(ctx->columns)){
+		exit(1);
+	}
+
+	/*process packets*/
+	if(ctx->profile){
+		prof_start();
+	}
+	if(follow){
+		follow_loop(fl, ctx);
+	}else{
+		pcap_loop(in, -1, handle_packet, (u_char*)ctx);
+	}
+	if(ctx->profile){
+		prof_finish();
+	}
+	
+	/*close files*/
+	pcap_close(in);
+	ret= ctx_finish(ctx) ? 0 : 1;
+	if(ctx->stats){
+		stats_print(sfile, gfile, ctx->stats);
+		fclose(sfile);
+		if(gfile){
+			fclose(gfile);
+		}
+	}else if(ctx->out){
+		pcap_dump_close(ctx->out);
+	}
+
+	/*Delete all connections*/
+	warn_summary();
+	print_alloc_stats();
+	if(ctx->profile){
+		prof_report();
+	}
+	ctx_free(ctx);
+	free(filter.sel);
+return ret;
+}
+
+void version()
+{
+	dbgprintf(0, "dccp2tcp version %.1f\n",DCCP2TCP_VERSION);
+	dbgprintf(0, "Copyright (C) %i Samuel Jero <sj323707@ohio.edu>\n",COPYRIGHT_YEAR);
+	dbgprintf(0, "This program comes with ABSOLUTELY NO WARRANTY.\n");
+	dbgprintf(0, "This is free software, and you are welcome to\n");
+	dbgprintf(0, "redistribute it under certain conditions.\n");
+	exit(0);
+}
+
+/*Usage information for program*/
+void usage()
+{
+	dbgprintf(0,"Usage: dccp2tcp [-v] [-h] [-V] [-y] [-g] [-s] [--stats[=csv|json]]\n"
+			"                [--xplot[=prefix]] [--xplot-points=N]\n"
+			"                [--columns=file] [--no-pcap] [--headers-only] [--profile]\n"
+			"                [--flush-packets=N] [--flush-ms=M] [--follow]\n"
+			"                [--select=end[,end]] [--ccid=2|3] [--min-packets=N] [--min-bytes=N]\n"
+			"                dccp_file [tcp_file]\n"
+			"       dccp2tcp [options] [-j N] --outdir=dir input...\n");
+	dbgprintf(0, "          -v   verbose. May be repeated for additional verbosity.\n");
+	dbgprintf(0, "          -V   Version information\n");
+	dbgprintf(0, "          -h   Help\n");
+	dbgprintf(0, "          -y   Yellow line is highest ACK\n");
+	dbgprintf(0, "          -g   Green line is highest ACK\n");
+	dbgprintf(0, "          -s   convert ACK Vectors to SACKS\n");
+	dbgprintf(0, "          --stats[=csv|json]  write per half-connection statistics\n");
+	dbgprintf(0, "                              to tcp_file instead of a TCP capture\n");
+	dbgprintf(0, "          --xplot[=prefix]    write tcptrace style time sequence graphs\n");
+	dbgprintf(0, "                              (prefixa2b_tsg.xpl, ...) while converting\n");
+	dbgprintf(0, "          --xplot-points=N    merge events to keep each graph under N points\n");
+	dbgprintf(0, "          --columns=file      write a columnar per-packet export of the mapping\n");
+	dbgprintf(0, "          --no-pcap           don't write a TCP capture (no tcp_file)\n");
+	dbgprintf(0, "          --headers-only      write only the headers of each TCP packet\n");
+	dbgprintf(0, "          --profile           print the time spent in each conversion stage\n");
+	dbgprintf(0, "          --flush-packets=N   flush tcp_file (e.g. - for stdout) every N packets\n");
+	dbgprintf(0, "          --flush-ms=M        flush tcp_file every M ms of capture time\n");
+	dbgprintf(0, "          --follow            keep converting records appended to dccp_file\n");
+	dbgprintf(0, "                              (and its replacement, when rotated) until\n");
+	dbgprintf(0, "                              interrupted, flushing the output as we go\n");
+	dbgprintf(0, "          --select=end[,end]  only convert connections between these ends\n");
+	dbgprintf(0, "                              (addr, addr:port, [v6addr]:port, :port or *).\n");
+	dbgprintf(0, "                              May be repeated\n");
+	dbgprintf(0, "          --ccid=2|3          only convert connections using this CCID\n");
+	dbgprintf(0, "          --min-packets=N     only convert connections of at least N packets\n");
+	dbgprintf(0, "          --min-bytes=N       only convert connections of at least N data bytes\n");
+	dbgprintf(0, "          --outdir=dir        convert each input (a capture, or a directory of\n");
+	dbgprintf(0, "                              captures) to dir/stem.tcp.pcap, in parallel\n");
+	dbgprintf(0, "          -j N                use N threads with --outdir (default: one per CPU)\n");
+	exit(0);
+}
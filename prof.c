@@ -0,0 +1,159 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Functions for profiling where conversion time goes.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	1)Time is charged to exactly one stage at a time. prof_enter() switches
+		to a new stage and returns the old one, prof_leave() switches back, so
+		nested stages are not counted twice (do_encap() doesn't include the
+		time of get_host(), which it calls).
+	2)Ticks are TSC cycles on x86 and nanoseconds elsewhere. They are
+		converted to time using the wall clock time of the whole run.
+	3)Everything is behind the profile flag (PROF_ENTER/PROF_LEAVE), so
+		the cost without --profile is one branch per stage.
+	4)Counters are per context (struct prof_state in struct d2t_ctx).
+******************************************************************************/
+#include "dccp2tcp.h"
+#include <sys/resource.h>
+
+/*Stage names for the report*/
+static const char *prof_names[NUM_PROF]={
+	"read",				/*PROF_READ*/
+	"do_encap",			/*PROF_ENCAP*/
+	"get_host",			/*PROF_HOST*/
+	"parse_options",	/*PROF_OPTIONS*/
+	"handle_request",	/*PROF_HANDLE + DCCP_PKT_REQUEST*/
+	"handle_response",
+	"handle_data",
+	"handle_ack",
+	"handle_dataack",
+	"handle_closereq",
+	"handle_close",
+	"handle_reset",
+	"handle_sync",
+	"handle_syncack",
+	"checksum",			/*PROF_CHECKSUM*/
+	"stats/xplot/cols",	/*PROF_OUTPUT*/
+	"pcap_dump",		/*PROF_DUMP*/
+};
+
+u_int64_t prof_wall_ns();
+
+
+/*Read the tick counter*/
+static inline u_int64_t prof_tick()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return prof_wall_ns();
+#endif
+}
+
+/*Monotonic wall clock in nanoseconds*/
+u_int64_t prof_wall_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+return (u_int64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+/*Start profiling. Time until the first prof_enter() is charged to reading*/
+void prof_start()
+{
+	struct prof_state	*p=&d2t->prof;
+
+	p->start_ns=prof_wall_ns();
+	p->start_tick=p->last=prof_tick();
+	p->cur=PROF_READ;
+}
+
+/*Charge the time since the last switch to the current stage, then switch
+ * to stage s. Returns the stage to pass to prof_leave()*/
+enum prof_stage prof_enter(enum prof_stage s)
+{
+	struct prof_state	*p=&d2t->prof;
+	u_int64_t			now=prof_tick();
+	enum prof_stage		prev=p->cur;
+
+	p->ticks[p->cur]+=now - p->last;
+	p->last=now;
+	p->cur=s;
+	p->calls[s]++;
+return prev;
+}
+
+/*Charge the time since the last switch to the current stage and go back
+ * to stage prev*/
+void prof_leave(enum prof_stage prev)
+{
+	struct prof_state	*p=&d2t->prof;
+	u_int64_t			now=prof_tick();
+
+	p->ticks[p->cur]+=now - p->last;
+	p->last=now;
+	p->cur=prev;
+}
+
+/*Stop profiling*/
+void prof_finish()
+{
+	struct prof_state	*p=&d2t->prof;
+
+	prof_leave(PROF_READ);
+	p->end_tick=p->last;
+	p->end_ns=prof_wall_ns();
+}
+
+/*Print the per-stage breakdown*/
+void prof_report()
+{
+	struct prof_state	*p=&d2t->prof;
+	struct rusage		ru;
+	u_int64_t			total;
+	u_int64_t			packets;
+	double				secs;
+	double				ns_per_tick;
+
+	total=p->end_tick - p->start_tick;
+	secs=(p->end_ns - p->start_ns)/1e9;
+	ns_per_tick= total ? (p->end_ns - p->start_ns)/(double)total : 0;
+	packets=p->calls[PROF_ENCAP];
+	p->calls[PROF_READ]=packets;	/*one read per packet*/
+
+	dbgprintf(0,"Profile: %llu packets in %.3f s (%.0f packets/s), %llu converted\n",
+			(unsigned long long)packets, secs, secs > 0 ? packets/secs : 0,
+			(unsigned long long)(p->calls[PROF_CHECKSUM]));
+	dbgprintf(0,"%-18s %12s %14s %7s %10s\n", "stage", "calls", "ticks", "%", "ns/call");
+	for(int i=0; i < NUM_PROF; i++){
+		if(p->ticks[i]==0 && p->calls[i]==0){
+			continue;
+		}
+		dbgprintf(0,"%-18s %12llu %14llu %6.1f%% %10.1f\n", prof_names[i],
+				(unsigned long long)p->calls[i], (unsigned long long)p->ticks[i],
+				total ? 100.0*p->ticks[i]/total : 0,
+				p->calls[i] ? p->ticks[i]*ns_per_tick/p->calls[i] : 0);
+	}
+	if(getrusage(RUSAGE_SELF, &ru)==0){
+		dbgprintf(0,"Max resident set size: %ld kB\n", ru.ru_maxrss);
+	}
+}
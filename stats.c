@@ -0,0 +1,384 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Functions for computing per half-connection statistics
+		directly, without writing a TCP capture.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+******************************************************************************/
+#include "dccp2tcp.h"
+
+void stats_ack(const struct const_packet *pkt, struct hcon *hcn, struct hcon *o_hcn, d_seq_num ack);
+void stats_run(struct hcon *hcn, int state, d_seq_num top, int len, u_int64_t *bytes);
+void stats_goodput(struct hcon *hcn, const struct timeval *ts, u_int64_t bytes);
+double tv_diff(const struct timeval *a, const struct timeval *b);
+int print_ccid(struct hcon *hcn);
+
+
+/*Update statistics for a packet sent by h1 to h2.
+ * Must be called after the packet has been converted*/
+void stats_packet(const struct const_packet *pkt, struct hcon *h1, struct hcon *h2)
+{
+	struct dccp_hdr 			*dccph;
+	struct dccp_hdr_ext 		*dccphex;
+	struct dccp_hdr_ack_bits 	*dccphack;
+	struct hstats				*st;
+	int							datalength;
+	int							i;
+
+	/*cast header pointers*/
+	dccph=(struct dccp_hdr*)pkt->data;
+	dccphex=(struct dccp_hdr_ext*)(pkt->data+sizeof(struct dccp_hdr));
+	dccphack=(struct dccp_hdr_ack_bits*)(pkt->data+ sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext));
+
+	/*Packet counts*/
+	st=&h1->stats;
+	if(st->pkts==0){
+		st->first=pkt->h->ts;
+	}
+	st->last=pkt->h->ts;
+	st->pkts++;
+	if(dccph->dccph_type==DCCP_PKT_DATA || dccph->dccph_type==DCCP_PKT_DATAACK){
+		datalength=pkt->length + pkt->tail_len - dccph->dccph_doff*4;
+		if(datalength > 0){
+			st->data_pkts++;
+			st->bytes+=datalength;
+		}
+	}
+
+	/*Record send time for RTT computation*/
+	if(h1->table!=NULL && h1->table[h1->cur].old==ntohl(dccphex->dccph_seq_low)){
+		if(st->sent==NULL){
+			st->sent=calloc(h1->size, sizeof(struct timeval));
+			if(st->sent==NULL){
+				dbgprintf(0,"Error: Couldn't allocate Memory\n");
+				exit(1);
+			}
+		}
+
+		/*forget the send times of any missing packets*/
+		if(st->last_slot!=h1->cur){
+			for(i=(st->last_slot+1)%h1->size; i!=h1->cur; i=(i+1)%h1->size){
+				timerclear(&st->sent[i]);
+			}
+		}
+		st->sent[h1->cur]=pkt->h->ts;
+		st->last_slot=h1->cur;
+	}
+
+	/*Acknowledgment statistics*/
+	if(dccph->dccph_type==DCCP_PKT_DATA || dccph->dccph_type==DCCP_PKT_REQUEST){
+		return;
+	}
+	if(pkt->length < sizeof(struct dccp_hdr) + sizeof(struct dccp_hdr_ext) + sizeof(struct dccp_hdr_ack_bits)){
+		return;
+	}
+	if(h2->table==NULL){
+		return;
+	}
+	stats_ack(pkt, h2, h1, ntohl(dccphack->dccph_ack_nr_low));
+}
+
+/*Account for an acknowledgment of hcn's packets, sent by o_hcn*/
+void stats_ack(const struct const_packet *pkt, struct hcon *hcn, struct hcon *o_hcn, d_seq_num ack)
+{
+	struct dccp_hdr 			*dccph;
+	struct hstats				*st;
+	u_int64_t					bytes=0;
+	const struct ack_vect		*av=NULL;
+	int							n;
+	int							i;
+	double						rtt;
+
+	dccph=(struct dccp_hdr*)pkt->data;
+	st=&hcn->stats;
+
+	/*The first acknowledgment covers everything since the initial sequence number*/
+	if(!st->acked){
+		st->acked=1;
+		st->ack_high=hcn->table[0].old - 1;
+	}
+
+	/*Ignore old or duplicate acknowledgments*/
+	if((int)(ack - st->ack_high) <= 0){
+		return;
+	}
+
+	/*RTT sample from the packet that clocked out this ACK*/
+	i=lookup_seq(hcn, ack);
+	if(i >= 0 && st->sent!=NULL && timerisset(&st->sent[i])){
+		rtt=tv_diff(&pkt->h->ts, &st->sent[i]);
+		if(rtt >= 0){
+			if(st->rtt_cnt==0 || rtt < st->rtt_min){
+				st->rtt_min=rtt;
+			}
+			if(rtt > st->rtt_max){
+				st->rtt_max=rtt;
+			}
+			st->rtt_sum+=rtt;
+			st->rtt_cnt++;
+		}
+	}
+
+	/*Walk the Ack Vector, if any, down to what we have already counted*/
+	n=-1;
+	if(dccph->dccph_type!=DCCP_PKT_RESPONSE){
+		av=read_ack_vect(pkt->data, o_hcn);
+		n=av->n;
+	}
+	for(i=0; i < n && (int)(av->runs[i].top - st->ack_high) > 0; i++){
+		/*States 0 and 1 are received (1 is ECN marked), 3 is not received*/
+		stats_run(hcn, av->runs[i].state, av->runs[i].top, av->runs[i].len, &bytes);
+	}
+
+	/*Without an Ack Vector, everything up to the ACK was received*/
+	if(n < 0){
+		stats_run(hcn, AV_RECEIVED, ack, ack - st->ack_high, &bytes);
+	}
+
+	st->ack_high=ack;
+	stats_goodput(hcn, &pkt->h->ts, bytes);
+}
+
+/*Account for a run of len packets ending with sequence number top that were
+ * all in one Ack Vector state (enum av_state). Packets already counted are
+ * skipped.*/
+void stats_run(struct hcon *hcn, int state, d_seq_num top, int len, u_int64_t *bytes)
+{
+	struct hstats		*st;
+	int					i;
+
+	st=&hcn->stats;
+
+	/*Only count packets newer than those we've already seen acknowledged*/
+	if((int)(top - st->ack_high) <= 0){
+		return;
+	}
+	if((int)(top - st->ack_high) < len){
+		len=top - st->ack_high;
+	}
+
+	if(state==AV_ECN){
+		st->ecn+=len;
+	}
+	if(state==AV_LOST){
+		st->lost+=len;
+		st->loss_runs++;
+		return;
+	}
+
+	/*Sum data bytes of received packets. Consecutive sequence numbers
+	 * normally occupy consecutive table entries*/
+	i=lookup_seq(hcn, top);
+	while(len > 0 && i >= 0){
+		if(i >= hcn->used || hcn->table[i].old!=top){
+			i=lookup_seq(hcn, top);
+			if(i < 0){
+				break;
+			}
+		}
+		if(hcn->table[i].type==DCCP_PKT_DATA || hcn->table[i].type==DCCP_PKT_DATAACK){
+			*bytes+=hcn->table[i].size;
+		}
+		i=(i - 1 + hcn->size)%hcn->size;
+		top--;
+		len--;
+	}
+}
+
+/*Add delivered bytes to the goodput interval containing ts*/
+void stats_goodput(struct hcon *hcn, const struct timeval *ts, u_int64_t bytes)
+{
+	struct hstats		*st;
+	u_int64_t			*tmp;
+	double				secs;
+	int					intv;
+	int					len;
+
+	st=&hcn->stats;
+	if(bytes==0){
+		return;
+	}
+	st->delivered+=bytes;
+
+	secs=tv_diff(ts, &st->first)/STATS_INTERVAL;
+	intv= secs < 0 ? 0 : (secs > (1<<30) ? (1<<30) : (int)secs);
+
+	/*grow interval array*/
+	if(intv >= st->gput_len){
+		len=st->gput_len ? st->gput_len : 64;
+		while(len <= intv && len < (1<<30)){
+			len*=2;
+		}
+		tmp= len > intv ? realloc(st->gput, (size_t)len*sizeof(u_int64_t)) : NULL;
+		if(tmp==NULL){
+			/*e.g. a bogus timestamp years after the first packet*/
+			if(!d2t->error){
+				dbgprintf(0,"Error: Couldn't allocate Memory for %i goodput intervals\n", intv + 1);
+			}
+			d2t->error=1;
+			return;
+		}
+		memset(tmp + st->gput_len, 0, (len - st->gput_len)*sizeof(u_int64_t));
+		st->gput=tmp;
+		st->gput_len=len;
+	}
+
+	st->gput[intv]+=bytes;
+}
+
+/*Print statistics for all connections to f. With CSV, the goodput time
+ * series goes to a second table in gf (if not NULL)*/
+void stats_print(FILE *f, FILE *gf, enum stats_fmt fmt)
+{
+	struct connection 	*ptr;
+	struct hcon			*hcn;
+	struct hcon			*o_hcn;
+	struct hstats		*st;
+	double				dur;
+	int					num;
+	int					last;
+	int					first=1;
+
+	if(fmt==STATS_CSV){
+		fprintf(f,"connection,direction,src,sport,dst,dport,ccid,duration,packets,data_packets,"
+				"bytes,delivered,goodput_bps,lost,loss_runs,ecn,rtt_samples,rtt_min_ms,rtt_avg_ms,rtt_max_ms\n");
+	}else{
+		fprintf(f,"[\n");
+	}
+
+	num=0;
+	for(ptr=d2t->chead; ptr!=NULL; ptr=ptr->next){
+		num++;
+		if(ptr->A.state==IGNORE){
+			continue;	/*not selected*/
+		}
+		for(int dir=0; dir < 2; dir++){
+			hcn= dir ? &ptr->B : &ptr->A;
+			o_hcn= dir ? &ptr->A : &ptr->B;
+			st=&hcn->stats;
+			dur=tv_diff(&st->last,&st->first);
+
+			/*find the last goodput interval actually used*/
+			for(last=st->gput_len; last > 0 && st->gput[last-1]==0; last--);
+
+			if(fmt==STATS_CSV){
+				fprintf(f,"%i,%s,%s,%i,%s,%i,%i,%.6f,%llu,%llu,%llu,%llu,%.0f,%llu,%llu,%llu,%llu,%.3f,%.3f,%.3f\n",
+					num, dir ? "b2a" : "a2b", host_name(hcn), ntohs(hcn->port), host_name(o_hcn), ntohs(o_hcn->port),
+					print_ccid(hcn), dur, (unsigned long long)st->pkts, (unsigned long long)st->data_pkts,
+					(unsigned long long)st->bytes, (unsigned long long)st->delivered,
+					dur > 0 ? st->delivered*8/dur : 0, (unsigned long long)st->lost,
+					(unsigned long long)st->loss_runs, (unsigned long long)st->ecn, (unsigned long long)st->rtt_cnt,
+					st->rtt_min*1000, st->rtt_cnt ? st->rtt_sum*1000/st->rtt_cnt : 0, st->rtt_max*1000);
+				continue;
+			}
+
+			fprintf(f,"%s  {\"connection\": %i, \"direction\": \"%s\", \"src\": \"%s\", \"sport\": %i, "
+					"\"dst\": \"%s\", \"dport\": %i, \"ccid\": %i,\n", first ? "" : ",\n",
+					num, dir ? "b2a" : "a2b", host_name(hcn), ntohs(hcn->port), host_name(o_hcn), ntohs(o_hcn->port),
+					print_ccid(hcn));
+			fprintf(f,"   \"duration\": %.6f, \"packets\": %llu, \"data_packets\": %llu, \"bytes\": %llu, "
+					"\"delivered\": %llu, \"goodput_bps\": %.0f,\n", dur, (unsigned long long)st->pkts,
+					(unsigned long long)st->data_pkts, (unsigned long long)st->bytes,
+					(unsigned long long)st->delivered, dur > 0 ? st->delivered*8/dur : 0);
+			fprintf(f,"   \"lost\": %llu, \"loss_runs\": %llu, \"ecn\": %llu, \"rtt_samples\": %llu, \"rtt_min_ms\": %.3f, "
+					"\"rtt_avg_ms\": %.3f, \"rtt_max_ms\": %.3f,\n", (unsigned long long)st->lost,
+					(unsigned long long)st->loss_runs, (unsigned long long)st->ecn, (unsigned long long)st->rtt_cnt, st->rtt_min*1000,
+					st->rtt_cnt ? st->rtt_sum*1000/st->rtt_cnt : 0, st->rtt_max*1000);
+			fprintf(f,"   \"goodput_interval\": %i, \"goodput\": [", STATS_INTERVAL);
+			for(int i=0; i < last; i++){
+				fprintf(f,"%s%llu", i ? ", " : "", (unsigned long long)st->gput[i]);
+			}
+			fprintf(f,"]}");
+			first=0;
+		}
+	}
+
+	/*Goodput time series*/
+	if(fmt==STATS_CSV && gf){
+		fprintf(gf,"connection,direction,interval_start,delivered\n");
+		num=0;
+		for(ptr=d2t->chead; ptr!=NULL; ptr=ptr->next){
+			num++;
+			if(ptr->A.state==IGNORE){
+				continue;
+			}
+			for(int dir=0; dir < 2; dir++){
+				st= dir ? &ptr->B.stats : &ptr->A.stats;
+				for(last=st->gput_len; last > 0 && st->gput[last-1]==0; last--);
+				for(int i=0; i < last; i++){
+					fprintf(gf,"%i,%s,%i,%llu\n", num, dir ? "b2a" : "a2b", i*STATS_INTERVAL,
+							(unsigned long long)st->gput[i]);
+				}
+			}
+		}
+	}
+	if(fmt==STATS_JSON){
+		fprintf(f,"\n]\n");
+	}
+}
+
+/*Name of the goodput table for the CSV statistics file name: x.csv (or x)
+ * is x.goodput.csv. Returns a new string, or NULL if there is no memory*/
+char *stats_goodput_name(const char *file)
+{
+	char	*name;
+	int		len;
+
+	len=strlen(file);
+	if(len >= 4 && strcmp(file + len - 4, ".csv")==0){
+		len-=4;
+	}
+	name=malloc(len + strlen(".goodput.csv") + 1);
+	if(name==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		return NULL;
+	}
+	memcpy(name, file, len);
+	strcpy(name + len, ".goodput.csv");
+return name;
+}
+
+/*Free statistics memory*/
+void stats_free(struct hcon *hcn)
+{
+	free(hcn->stats.gput);
+	free(hcn->stats.sent);
+	hcn->stats.gput=NULL;
+	hcn->stats.sent=NULL;
+	hcn->stats.gput_len=0;
+}
+
+/*Difference between two times in seconds*/
+double tv_diff(const struct timeval *a, const struct timeval *b)
+{
+	return (a->tv_sec - b->tv_sec) + (a->tv_usec - b->tv_usec)/1000000.0;
+}
+
+/*CCID number of a half-connection, 0 if unknown*/
+int print_ccid(struct hcon *hcn)
+{
+	switch(hcn->type){
+		case CCID2:
+			return 2;
+		case CCID3:
+			return 3;
+		default:
+			return 0;
+	}
+}
@@ -0,0 +1,119 @@
+#!/bin/sh
+###############################################################################
+#Author: dccp2tcp contributors
+#
+# Date: 10/2026
+#
+# Golden output regression check over the bundled captures. Run by "make check".
+#	check.sh [-u] dccp2tcp
+# Every capture in ccid2_captures/, ccid3_captures/ and tests/captures/
+# (synthetic regression cases made with bench/gencap: many clients of one
+# server port, and a 128 byte snaplen) is converted with each TCP option
+# combination. Statistics, headers only, columns, graphs and the connection
+# filters are run on one capture each. Each conversion has a time limit, and
+# the SHA-256 of every file it writes is compared to tests/golden.sha256.
+# -u rewrites the golden file from the current binary (only do that for an
+# intended output change).
+#
+# Each run is appended to $CHECK_LOG (default $TMPDIR/dccp2tcp-check.log,
+# outside the source tree) as one line of JSON:
+#	{"time":..., "commit":..., "capture":..., "options":..., "result":...,
+#	 "wall_s":..., "packets":..., "max_rss_kb":...}
+###############################################################################
+
+UPDATE=0
+if [ "$1" = "-u" ]; then
+	UPDATE=1
+	shift
+fi
+D2T=${1:-./dccp2tcp}
+DIR=$(dirname "$0")
+GOLDEN=$DIR/golden.sha256
+LOG=${CHECK_LOG:-${TMPDIR:-/tmp}/dccp2tcp-check.log}
+LIMIT=120	#seconds per conversion, so a runaway fails instead of hanging
+OUT=$(mktemp -d) || exit 1
+trap 'rm -rf "$OUT"' EXIT
+
+COMMIT=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+NOW=$(date +%s)
+FAIL=0
+IN=$OUT/in.pcap
+C=$OUT/case
+: > "$OUT/sums"
+
+# run capture tag dccp2tcp_args...: convert into the empty directory $C and
+# check every file written there as capture.tag.file
+run(){
+	name=$1
+	tag=$2
+	shift 2
+	opts=$(echo "$*" | sed "s|$OUT/||g")
+	rm -rf "$C"
+	mkdir "$C" || exit 1
+
+	start=$(date +%s.%N)
+	timeout $LIMIT $D2T --profile "$@" 2>"$OUT/prof"
+	rc=$?
+	end=$(date +%s.%N)
+
+	result=ok
+	for f in $(ls "$C"); do
+		file="$name.$tag.$f"
+		sum=$(sha256sum "$C/$f" | cut -d' ' -f1)
+		echo "$sum  $file" >> "$OUT/sums"
+		if [ $UPDATE -eq 0 ] && ! grep -q "^$sum  $file\$" "$GOLDEN"; then
+			result=FAIL
+		fi
+	done
+	if [ $rc -ne 0 ]; then
+		result=error
+	elif [ $UPDATE -eq 1 ]; then
+		result=updated
+	fi
+	[ "$result" = ok ] || [ "$result" = updated ] || FAIL=1
+
+	awk -v t="$NOW" -v c="$COMMIT" -v cap="$name" -v o="$opts" -v r="$result" \
+			-v s="$start" -v e="$end" '
+		/^Profile:/ { pkts=$2 }
+		/^Max resident set size:/ { rss=$5 }
+		END { printf "{\"time\":%s,\"commit\":\"%s\",\"capture\":\"%s\",\"options\":\"%s\",\"result\":\"%s\",\"wall_s\":%.4f,\"packets\":%d,\"max_rss_kb\":%d}\n", t, c, cap, o, r, e - s, pkts, rss }
+	' "$OUT/prof" >> "$LOG"
+	printf "%-24s %-12s %s\n" "$name" "$tag" "$result"
+}
+
+# The TCP conversion options on every capture
+for cap in ccid2_captures/*.dmp.gz ccid3_captures/*.dmp.gz $DIR/captures/*.dmp.gz; do
+	name=$(basename "$cap" .dmp.gz)
+	zcat "$cap" > "$IN" || exit 1
+	for opts in "" "-s" "-s -s" "-y" "-g"; do
+		tag=$(echo "$opts" | tr -d ' -')
+		run "$name" "${tag:-default}" $opts "$IN" "$C/pcap"
+	done
+done
+
+# The other outputs, on a CCID 2 capture with losses
+name=1Mbit_limited
+zcat ccid2_captures/$name.dmp.gz > "$IN" || exit 1
+run $name stats_csv --stats "$IN" "$C/stats.csv"
+run $name stats_json --stats=json "$IN" "$C/stats.json"
+run $name headers -s -s --headers-only "$IN" "$C/pcap"
+run $name columns --no-pcap --columns="$C/columns" "$IN"
+run $name xplot --no-pcap --xplot="$C/" --xplot-points=500 "$IN"
+
+# Connection filters, on a capture of two CCID 3 connections
+name=multiple_connections
+zcat ccid3_captures/$name.dmp.gz > "$IN" || exit 1
+run $name select -s --select=132.235.3.34:45622 "$IN" "$C/pcap"
+run $name ccid -s --ccid=2 "$IN" "$C/pcap"
+run $name min_packets -s --min-packets=5848 "$IN" "$C/pcap"
+run $name min_bytes -s --min-bytes=42080 "$IN" "$C/pcap"
+
+if [ $UPDATE -eq 1 ]; then
+	cp "$OUT/sums" "$GOLDEN"
+	echo "Golden outputs updated"
+elif [ $FAIL -ne 0 ] || ! cmp -s "$OUT/sums" "$GOLDEN"; then
+	echo "Output differs from golden results"
+	exit 1
+else
+	echo "All outputs match"
+fi
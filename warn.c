@@ -0,0 +1,110 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Functions for counting warnings and printing a summary.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	1)Every warning is counted, globally and for the half-connection it
+		concerns (if known). Only the first WARN_SAMPLES of each class are
+		printed, unless -v is given twice. warn_summary() reports the rest.
+******************************************************************************/
+#include "dccp2tcp.h"
+
+/*Warning class descriptions*/
+static const struct{
+	int			level;		/*Debug level the warning is printed at*/
+	const char	*name;		/*Description for the summary*/
+} warn_info[NUM_WARN]={
+	{1, "Connection uninitialized"},		/*WARN_UNINIT*/
+	{1, "Missing packet"},					/*WARN_MISSING*/
+	{1, "More than 100 packets missing"},	/*WARN_MISSING_MANY*/
+	{1, "Sequence number not found"},		/*WARN_SEQ_NOT_FOUND*/
+	{0, "Option extends into data"},		/*WARN_OPT_OVERRUN*/
+	{0, "Bad option"},						/*WARN_BAD_OPTION*/
+	{1, "Invalid Ack Vector"},				/*WARN_ACK_VECT*/
+	{0, "Response without a Request"},		/*WARN_NO_REQUEST*/
+	{0, "TCP window overflow"},				/*WARN_WINDOW*/
+	{0, "Invalid DCCP packet type"},		/*WARN_BAD_TYPE*/
+	{0, "DCCP packet truncated"},			/*WARN_TRUNCATED*/
+	{1, "Wrong or unknown protocol"},		/*WARN_PROTOCOL*/
+};
+
+
+/*Count a warning about hcn (may be NULL). Returns true if this occurrence
+ * should be printed*/
+int warn_count(struct hcon *hcn, enum warn_class w)
+{
+	d2t->warn_total[w]++;
+	if(hcn){
+		hcn->warns[w]++;
+	}
+	if(d2t->debug < warn_info[w].level){
+		return 0;
+	}
+	return d2t->warn_total[w] <= WARN_SAMPLES || d2t->debug >= 2;
+}
+
+/*Print how often each warning occurred. Warnings that were cut short are
+ * always summarized, the full table (per connection too) needs -v*/
+void warn_summary()
+{
+	struct connection	*ptr;
+	u_int64_t			shown;
+	int					num;
+	int					any;
+	u_int64_t			*total=d2t->warn_total;	/*Occurrences of each warning*/
+
+	for(int w=0; w < NUM_WARN; w++){
+		if(total[w]==0 || d2t->debug < warn_info[w].level){
+			continue;
+		}
+		shown= d2t->debug >= 2 ? total[w] : (total[w] < WARN_SAMPLES ? total[w] : WARN_SAMPLES);
+		if(shown < total[w]){
+			dbgprintf(0,"Warning: %s: %llu times (%llu not shown)\n", warn_info[w].name,
+					(unsigned long long)total[w], (unsigned long long)(total[w] - shown));
+		}else{
+			dbgprintf(1,"Warning: %s: %llu times\n", warn_info[w].name,
+					(unsigned long long)total[w]);
+		}
+	}
+
+	/*Per connection counts*/
+	if(d2t->debug < 1){
+		return;
+	}
+	num=0;
+	for(ptr=d2t->chead; ptr!=NULL; ptr=ptr->next){
+		num++;
+		for(int dir=0; dir < 2; dir++){
+			struct hcon *hcn= dir ? &ptr->B : &ptr->A;
+			any=0;
+			for(int w=0; w < NUM_WARN; w++){
+				if(hcn->warns[w]==0){
+					continue;
+				}
+				if(!any){
+					dbgprintf(1,"Connection %i, %s:%i:\n", num, host_name(hcn), ntohs(hcn->port));
+					any=1;
+				}
+				dbgprintf(1,"    %s: %u\n", warn_info[w].name, hcn->warns[w]);
+			}
+		}
+	}
+}
@@ -0,0 +1,424 @@
+/******************************************************************************
+Utility to convert a DCCP flow to a TCP flow for DCCP analysis via
+		tcptrace. Functions for writing time sequence graphs (xplot format)
+		directly while converting.
+
+Copyright (C) 2026  dccp2tcp contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Author: dccp2tcp contributors
+Date: 10/2026
+
+Notes:
+	1)Each half-connection gets one graph, named like tcptrace's a2b_tsg.xpl,
+		showing its data and the other host's ACKs, window and SACKs.
+	2)With a point limit, consecutive events are merged into a single
+		point. The number of events merged doubles each time half of the
+		remaining points are used, so a graph never exceeds the limit.
+	3)Only XPLOT_FILES graph files (fewer if the descriptor limit is hit)
+		are open at a time, so a capture with many connections doesn't run
+		out of file descriptors. The least recently used one is closed when
+		another is needed, and reopened for appending when written again.
+	4)If a graph file can't be created or reopened, all graphs are
+		finished as they are and no more are written (d2t->error is set).
+******************************************************************************/
+#include "dccp2tcp.h"
+#include <errno.h>
+
+/*Time sequence graph state for a half-connection*/
+struct xpl{
+	FILE				*f;			/*Graph file (NULL while closed)*/
+	char				*fname;		/*Graph file name*/
+	struct xpl			*prev;		/*More recently used open graph*/
+	struct xpl			*next;		/*Less recently used open graph*/
+	int					points;		/*Points written so far*/
+	int					limit;		/*Points at which to double the stride*/
+	int					stride;		/*Events merged into each point*/
+	int					data_cnt;	/*Data segments merged so far*/
+	struct timeval		data_t1;	/*Time of first merged segment*/
+	struct timeval		data_t2;	/*Time of last merged segment*/
+	u_int32_t			data_lo;	/*Lowest merged sequence number*/
+	u_int32_t			data_hi;	/*Highest merged sequence number*/
+	int					ack_cnt;	/*ACK updates since last plotted*/
+	int					have_ack;	/*Have we plotted an ACK yet?*/
+	struct timeval		ack_t;		/*Time of last plotted ACK*/
+	u_int32_t			ack;		/*Last plotted ACK*/
+	u_int32_t			win;		/*Last plotted window edge*/
+	int					sack_cnt;	/*SACK options since last plotted*/
+	const char			*color;		/*Current color*/
+};
+
+struct xpl* xplot_open(struct hcon *hcn, struct hcon *o_hcn);
+int xplot_file(struct xpl *x, const char *mode);
+void xplot_close(struct xpl *x);
+void xplot_fail(struct hcon *hcn);
+void xplot_data(struct xpl *x, const struct timeval *t, u_int32_t seq, int len, struct tcphdr *tcph);
+void xplot_ack(struct xpl *x, const struct timeval *t, struct tcphdr *tcph);
+void xplot_flush_data(struct xpl *x);
+void xplot_point(struct xpl *x, int cnt);
+void xplot_color(struct xpl *x, const char *color);
+char* host_label(char *buf, int num);
+
+
+/*Add a converted packet sent by h1 to h2 to the time sequence graphs*/
+void xplot_packet(const struct packet *new, struct hcon *h1, struct hcon *h2)
+{
+	struct tcphdr		*tcph;
+	int					len;
+
+	tcph=(struct tcphdr*)new->data;
+	len=new->length - tcph->doff*4;
+
+	/*Data goes on this half-connection's graph*/
+	if(h1->xpl==NULL){
+		h1->xpl=xplot_open(h1, h2);
+		if(h1->xpl==NULL){
+			return;
+		}
+	}else if(!xplot_file(h1->xpl, "a")){
+		xplot_fail(h1);
+		return;
+	}
+	xplot_data(h1->xpl, &new->h->ts, ntohl(tcph->seq), len, tcph);
+
+	/*ACKs go on the other half-connection's graph*/
+	if(tcph->ack){
+		if(h2->xpl==NULL){
+			h2->xpl=xplot_open(h2, h1);
+			if(h2->xpl==NULL){
+				return;
+			}
+		}else if(!xplot_file(h2->xpl, "a")){
+			xplot_fail(h2);
+			return;
+		}
+		xplot_ack(h2->xpl, &new->h->ts, tcph);
+	}
+}
+
+/*Finish and close all time sequence graphs*/
+void xplot_finish()
+{
+	struct connection *ptr;
+	struct xpl *x;
+
+	for(ptr=d2t->chead; ptr!=NULL; ptr=ptr->next){
+		for(int dir=0; dir < 2; dir++){
+			x= dir ? ptr->B.xpl : ptr->A.xpl;
+			if(x==NULL){
+				continue;
+			}
+			if(xplot_file(x, "a")){
+				xplot_flush_data(x);
+				fprintf(x->f,"go\n");
+				xplot_close(x);
+			}else{
+				d2t->error=1;
+			}
+			free(x->fname);
+			free(x);
+		}
+		ptr->A.xpl=NULL;
+		ptr->B.xpl=NULL;
+	}
+}
+
+/*Give up on the graphs after hcn's file couldn't be reopened: finish the
+ * others and stop writing graphs*/
+void xplot_fail(struct hcon *hcn)
+{
+	free(hcn->xpl->fname);
+	free(hcn->xpl);
+	hcn->xpl=NULL;
+	xplot_finish();
+	d2t->xplot=NULL;
+	d2t->error=1;
+}
+
+/*Write out what is buffered for all graphs, so they can be viewed while
+ * converting. Merged points still being collected stay pending*/
+void xplot_flush()
+{
+	for(struct xpl *x=d2t->xpl_head; x!=NULL; x=x->next){
+		fflush(x->f);
+	}
+}
+
+/*Create the graph file for a half-connection. Returns NULL (and stops
+ * writing graphs) if it can't be created*/
+struct xpl* xplot_open(struct hcon *hcn, struct hcon *o_hcn)
+{
+	struct xpl	*x;
+	char		fname[1024];
+	char		l1[16];
+	char		l2[16];
+
+	/*tcptrace style file name*/
+	snprintf(fname,1024,"%s%s2%s_tsg.xpl", d2t->xplot, host_label(l1,hcn->num), host_label(l2,o_hcn->num));
+
+	x=malloc(sizeof(struct xpl));
+	if(x==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+	memset(x,0,sizeof(struct xpl));
+	x->stride=1;
+	x->limit=d2t->xplot_points/2;
+	x->fname=strdup(fname);
+	if(x->fname==NULL){
+		dbgprintf(0,"Error: Couldn't allocate Memory\n");
+		exit(1);
+	}
+
+	hcn->xpl=x;
+	if(!xplot_file(x, "w")){
+		xplot_fail(hcn);
+		return NULL;
+	}
+
+	fprintf(x->f,"timeval unsigned\ntitle\n%s:%i_==>_%s:%i (time sequence graph)\n",
+			host_name(hcn), ntohs(hcn->port), host_name(o_hcn), ntohs(o_hcn->port));
+	fprintf(x->f,"xlabel\ntime\nylabel\nsequence number\n");
+	dbgprintf(1,"Writing time sequence graph %s\n", fname);
+	return x;
+}
+
+/*Make sure the file of graph x is open, closing the least recently used
+ * one if too many are. mode is "w" to create it, "a" to reopen it.
+ * Returns 0 if it can't be opened*/
+int xplot_file(struct xpl *x, const char *mode)
+{
+	if(x->f==NULL){
+		if(d2t->xpl_open >= XPLOT_FILES){
+			xplot_close(d2t->xpl_tail);
+		}
+		/*with a lower descriptor limit, keep fewer files open*/
+		while((x->f=fopen(x->fname, mode))==NULL && errno==EMFILE && d2t->xpl_open > 0){
+			xplot_close(d2t->xpl_tail);
+		}
+		if(x->f==NULL){
+			dbgprintf(0,"Error opening graph file %s\n", x->fname);
+			return 0;
+		}
+		d2t->xpl_open++;
+	}else if(x==d2t->xpl_head){
+		return 1;
+	}else{
+		/*unlink*/
+		x->prev->next=x->next;
+		if(x->next){
+			x->next->prev=x->prev;
+		}else{
+			d2t->xpl_tail=x->prev;
+		}
+	}
+
+	/*most recently used*/
+	x->prev=NULL;
+	x->next=d2t->xpl_head;
+	if(d2t->xpl_head){
+		d2t->xpl_head->prev=x;
+	}else{
+		d2t->xpl_tail=x;
+	}
+	d2t->xpl_head=x;
+return 1;
+}
+
+/*Close the file of graph x until it is written again*/
+void xplot_close(struct xpl *x)
+{
+	if(fclose(x->f)!=0){
+		dbgprintf(0,"Error writing graph file %s\n", x->fname);
+		d2t->error=1;
+	}
+	x->f=NULL;
+	d2t->xpl_open--;
+	if(x->prev){
+		x->prev->next=x->next;
+	}else{
+		d2t->xpl_head=x->next;
+	}
+	if(x->next){
+		x->next->prev=x->prev;
+	}else{
+		d2t->xpl_tail=x->prev;
+	}
+}
+
+/*Plot a data segment*/
+void xplot_data(struct xpl *x, const struct timeval *t, u_int32_t seq, int len, struct tcphdr *tcph)
+{
+	/*Connection setup and teardown are always plotted*/
+	if(tcph->syn || tcph->fin || tcph->rst){
+		xplot_flush_data(x);
+		xplot_color(x,"white");
+		fprintf(x->f,"darrow %li.%06li %u\natext %li.%06li %u\n%s\n",
+				(long)t->tv_sec, (long)t->tv_usec, seq,
+				(long)t->tv_sec, (long)t->tv_usec, seq,
+				tcph->syn ? "SYN" : (tcph->rst ? "RST" : "FIN"));
+		xplot_point(x,2);
+		return;
+	}
+	if(len <= 0){
+		return;
+	}
+
+	/*Merge into pending segments*/
+	if(x->data_cnt==0){
+		x->data_t1=*t;
+		x->data_lo=seq;
+		x->data_hi=seq+len;
+	}
+	if((int)(seq - x->data_lo) < 0){
+		x->data_lo=seq;
+	}
+	if((int)(seq + len - x->data_hi) > 0){
+		x->data_hi=seq+len;
+	}
+	x->data_t2=*t;
+	x->data_cnt++;
+
+	if(x->data_cnt >= x->stride){
+		xplot_flush_data(x);
+	}
+}
+
+/*Plot pending (merged) data segments*/
+void xplot_flush_data(struct xpl *x)
+{
+	if(x->data_cnt==0){
+		return;
+	}
+	xplot_color(x,"white");
+	fprintf(x->f,"uarrow %li.%06li %u\nline %li.%06li %u %li.%06li %u\n",
+			(long)x->data_t2.tv_sec, (long)x->data_t2.tv_usec, x->data_hi,
+			(long)x->data_t1.tv_sec, (long)x->data_t1.tv_usec, x->data_lo,
+			(long)x->data_t2.tv_sec, (long)x->data_t2.tv_usec, x->data_hi);
+	x->data_cnt=0;
+	xplot_point(x,2);
+}
+
+/*Plot an ACK, window, and SACK blocks*/
+void xplot_ack(struct xpl *x, const struct timeval *t, struct tcphdr *tcph)
+{
+	u_char		*opt;
+	u_char		*end;
+	u_int32_t	ack;
+	u_int32_t	win;
+	u_int32_t	L;
+	u_int32_t	R;
+
+	ack=ntohl(tcph->ack_seq);
+	win=ack + ntohs(tcph->window);
+
+	/*ACK and window lines are drawn as steps from the last plotted value*/
+	if(!x->have_ack){
+		x->have_ack=1;
+		x->ack_t=*t;
+		x->ack=ack;
+		x->win=win;
+	}
+	x->ack_cnt++;
+	if((ack!=x->ack || win!=x->win) && x->ack_cnt >= x->stride){
+		xplot_color(x,"green");
+		fprintf(x->f,"line %li.%06li %u %li.%06li %u\nline %li.%06li %u %li.%06li %u\n",
+				(long)x->ack_t.tv_sec, (long)x->ack_t.tv_usec, x->ack,
+				(long)t->tv_sec, (long)t->tv_usec, x->ack,
+				(long)t->tv_sec, (long)t->tv_usec, x->ack,
+				(long)t->tv_sec, (long)t->tv_usec, ack);
+		xplot_color(x,"yellow");
+		fprintf(x->f,"line %li.%06li %u %li.%06li %u\nline %li.%06li %u %li.%06li %u\n",
+				(long)x->ack_t.tv_sec, (long)x->ack_t.tv_usec, x->win,
+				(long)t->tv_sec, (long)t->tv_usec, x->win,
+				(long)t->tv_sec, (long)t->tv_usec, x->win,
+				(long)t->tv_sec, (long)t->tv_usec, win);
+		x->ack_t=*t;
+		x->ack=ack;
+		x->win=win;
+		x->ack_cnt=0;
+		xplot_point(x,4);
+	}
+
+	/*SACK blocks*/
+	opt=(u_char*)tcph + sizeof(struct tcphdr);
+	end=(u_char*)tcph + tcph->doff*4;
+	while(opt < end && *opt!=0){
+		if(*opt==1){
+			opt++;
+			continue;
+		}
+		if(opt+1 >= end || *(opt+1) < 2){
+			break;
+		}
+		if(*opt==5){
+			if(++x->sack_cnt < x->stride){
+				break;
+			}
+			x->sack_cnt=0;
+			xplot_color(x,"purple");
+			for(int i=2; i+8 <= *(opt+1); i+=8){
+				memcpy(&L, opt+i, 4);
+				memcpy(&R, opt+i+4, 4);
+				fprintf(x->f,"line %li.%06li %u %li.%06li %u\n",
+						(long)t->tv_sec, (long)t->tv_usec, ntohl(L),
+						(long)t->tv_sec, (long)t->tv_usec, ntohl(R));
+				xplot_point(x,1);
+			}
+		}
+		opt+=*(opt+1);
+	}
+}
+
+/*Account for points written, increasing the stride as the limit approaches*/
+void xplot_point(struct xpl *x, int cnt)
+{
+	x->points+=cnt;
+	if(d2t->xplot_points <= 0){
+		return;
+	}
+	while(x->points >= x->limit && x->stride < (1<<30)){
+		x->stride*=2;
+		x->limit+=(d2t->xplot_points - x->limit + 1)/2;
+	}
+}
+
+/*Change the current color, if needed*/
+void xplot_color(struct xpl *x, const char *color)
+{
+	if(x->color!=color){
+		fprintf(x->f,"%s\n",color);
+		x->color=color;
+	}
+}
+
+/*tcptrace style host label: a, b, ..., z, aa, ab, ...*/
+char* host_label(char *buf, int num)
+{
+	char	tmp[16];
+	int		i=0;
+	int		j=0;
+
+	do{
+		tmp[i++]='a' + num%26;
+		num=num/26 - 1;
+	}while(num >= 0 && i < 15);
+
+	while(i > 0){
+		buf[j++]=tmp[--i];
+	}
+	buf[j]=0;
+	return buf;
+}